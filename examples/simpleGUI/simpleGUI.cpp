@@ -12,10 +12,14 @@
 #include <scene.hpp>
 #include <vulkan.hpp>
 
+#include <filesystem>
 #include <fstream>
 
 using namespace rayce;
 
+// seconds between picking up meshes and textures finished by a progressive scene load
+static constexpr float kSceneUpdateInterval = 0.5f;
+
 void storeImageAsPPM(const std::vector<byte> image, uint32 width, uint32 height)
 {
     const char* filename = "image.ppm";
@@ -61,9 +65,46 @@ bool SimpleGUI::onInitialize()
 
     pScene = std::make_unique<RayceScene>();
 
-    const str testScene = "./assets/scenes/demo/scene.xml";
+    const str testScene     = "./assets/scenes/demo/scene.xml";
+    const str compiledScene = "./cache/demo.rcs";
+
+    // meshes and textures are loaded in the background, rendering starts with whatever is ready
+    SceneLoadOptions options;
+    options.compiledSceneFile = compiledScene;
+    options.progressive       = true;
 
-    pScene->loadFromMitsubaFile(testScene, device, commandPool, 1.0f);
+    // the compiled scene skips all parsing, it is rejected and recompiled once the scene, a mesh or a texture changed
+    if (!std::filesystem::exists(compiledScene) || !pScene->loadFromCompiledFile(compiledScene, device, commandPool, options))
+    {
+        pScene->loadFromMitsubaFile(testScene, device, commandPool, 1.0f, options);
+    }
+
+    mVertexBuffers.clear();
+    mIndexBuffers.clear();
+    mAttributeBuffers.clear();
+    mTriangleMaterialBuffers.clear();
+    mBLAS.clear();
+    mInstances.clear();
+    mSpheres.clear();
+    pSphereBLAS.reset();
+    pTLAS.reset();
+    mSceneUpdateTimer = 0.0f;
+
+    buildAccelerationStructures();
+
+    // camera
+    float aspect = static_cast<float>(getWindowWidth()) / static_cast<float>(getWindowHeight());
+    pCamera      = std::make_unique<Camera>(aspect, 45.0f, 0.02f, 20.0f, 0.0f, 0.0f, vec3(0.0f, 2.0f, 8.0f), vec3(0.0f, 2.0f, 0.0f), getInput());
+
+    mAccumulationFrame = 0;
+
+    return true;
+}
+
+void SimpleGUI::buildAccelerationStructures()
+{
+    auto& device      = getDevice();
+    auto& commandPool = getCommandPool();
 
     auto& geometry = pScene->getGeometry();
 
@@ -73,47 +114,32 @@ bool SimpleGUI::onInitialize()
     auto& triangleMeshes    = geometry->getTriangleMeshes();
     auto& proceduralSpheres = geometry->getProceduralSpheres();
 
-    mVertexBuffers.clear();
-    mIndexBuffers.clear();
-    mBLAS.clear();
-    mInstances.clear();
-    mSpheres.clear();
-
-    std::vector<std::vector<std::pair<VkTransformMatrixKHR, uint32>>> instanceInfo(triangleMeshes.size() + 1);
+    // build times are part of the scene load profile
+    Timer buildTimer;
+    buildTimer.start();
+    uint64 buildBytes = 0;
 
-    for (ptr_size i = 0; i < triangleMeshes.size(); ++i)
+    // meshes are only ever appended while a scene loads, so existing BLAS stay valid and only new ones are built
+    for (ptr_size i = mBLAS.size(); i < triangleMeshes.size(); ++i)
     {
         const TriangleMeshGeometry& triMesh = triangleMeshes[i];
-        mVertexBuffers.push_back(triMesh.vertexBuffer->getVkBuffer());
+        mVertexBuffers.push_back(triMesh.positionBuffer->getVkBuffer());
         mIndexBuffers.push_back(triMesh.indexBuffer->getVkBuffer());
-        accelerationStructureInitData.vertexDataDeviceAddress = triMesh.vertexBuffer->getDeviceAddress();
+        // every slot of the descriptor array needs a buffer, proxies without attributes never read theirs
+        mAttributeBuffers.push_back(triMesh.attributeBuffer ? triMesh.attributeBuffer->getVkBuffer() : triMesh.positionBuffer->getVkBuffer());
+        mTriangleMaterialBuffers.push_back(triMesh.triangleMaterialBuffer ? triMesh.triangleMaterialBuffer->getVkBuffer() : triMesh.indexBuffer->getVkBuffer());
+        accelerationStructureInitData.vertexDataDeviceAddress = triMesh.positionBuffer->getDeviceAddress();
         accelerationStructureInitData.indexDataDeviceAddress  = triMesh.indexBuffer->getDeviceAddress();
+        accelerationStructureInitData.vertexStride            = sizeof(vec3);
+        accelerationStructureInitData.indexType               = triMesh.indexType;
         accelerationStructureInitData.maxVertex               = triMesh.maxVertex;
         accelerationStructureInitData.primitiveCount          = triMesh.primitiveCount;
         accelerationStructureInitData.procedural              = false;
         mBLAS.push_back(std::make_unique<AccelerationStructure>(device, commandPool, accelerationStructureInitData));
-
-        for (ptr_size j = 0; j < triMesh.transformationMatrices.size(); ++j)
-        {
-            auto instance         = std::make_unique<InstanceData>();
-            instance->materialId  = triMesh.materialId;
-            instance->lightId     = triMesh.lightId;
-            instance->objectIndex = i;
-            instance->sphereId    = -1;
-            mInstances.push_back(std::move(instance));
-
-            const auto& tr = triMesh.transformationMatrices[j];
-
-            VkTransformMatrixKHR transformationMatrix = {
-                tr(0, 0), tr(0, 1), tr(0, 2), tr(0, 3),
-                tr(1, 0), tr(1, 1), tr(1, 2), tr(1, 3),
-                tr(2, 0), tr(2, 1), tr(2, 2), tr(2, 3)
-            };
-            instanceInfo[i].push_back({ transformationMatrix, 0 });
-        }
+        buildBytes += mBLAS.back()->getSize();
     }
 
-    if (!proceduralSpheres.empty())
+    if (!proceduralSpheres.empty() && !pSphereBLAS)
     {
         // for now put all spheres in one BLAS - should be more efficent since we do not have more complex or moving stuff.
         // FIXME: The buffers should live somewhere else...
@@ -138,6 +164,46 @@ bool SimpleGUI::onInitialize()
         accelerationStructureInitData.primitiveCount        = mSpheres.size();
         accelerationStructureInitData.procedural            = true;
 
+        pSphereBLAS = std::make_unique<AccelerationStructure>(device, commandPool, accelerationStructureInitData);
+        buildBytes += pSphereBLAS->getSize();
+    }
+
+    // instances of already built meshes can be added later, the instance list and the TLAS are always rebuilt
+    mInstances.clear();
+
+    AccelerationStructureInitData tlasInitData{};
+    tlasInitData.type           = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
+    tlasInitData.primitiveCount = 0;
+
+    for (ptr_size i = 0; i < triangleMeshes.size(); ++i)
+    {
+        const TriangleMeshGeometry& triMesh = triangleMeshes[i];
+        for (ptr_size j = 0; j < triMesh.transformationMatrices.size(); ++j)
+        {
+            auto instance          = std::make_unique<InstanceData>();
+            instance->materialId   = triMesh.materialIds[j];
+            instance->lightId      = triMesh.lightIds[j];
+            instance->objectIndex  = i;
+            instance->sphereId     = -1;
+            instance->flags        = (triMesh.indexType == VK_INDEX_TYPE_UINT16 ? INSTANCE_FLAG_SHORT_INDICES : 0) | (triMesh.compactAttributes ? INSTANCE_FLAG_COMPACT_ATTRIBUTES : 0) |
+                              (triMesh.attributeBuffer ? 0 : INSTANCE_FLAG_NO_ATTRIBUTES) | (triMesh.triangleMaterialBuffer ? INSTANCE_FLAG_TRIANGLE_MATERIALS : 0);
+            mInstances.push_back(std::move(instance));
+
+            const auto& tr = triMesh.transformationMatrices[j];
+
+            VkTransformMatrixKHR transformationMatrix = {
+                tr(0, 0), tr(0, 1), tr(0, 2), tr(0, 3),
+                tr(1, 0), tr(1, 1), tr(1, 2), tr(1, 3),
+                tr(2, 0), tr(2, 1), tr(2, 2), tr(2, 3)
+            };
+            tlasInitData.transformMatrices.push_back(transformationMatrix);
+            tlasInitData.blasDeviceAddresses.push_back({ mBLAS[i]->getDeviceAddress(), 0 });
+            tlasInitData.primitiveCount++;
+        }
+    }
+
+    if (pSphereBLAS)
+    {
         auto tr = mat4::Identity();
 
         VkTransformMatrixKHR transformationMatrix = {
@@ -145,8 +211,9 @@ bool SimpleGUI::onInitialize()
             tr(1, 0), tr(1, 1), tr(1, 2), tr(1, 3),
             tr(2, 0), tr(2, 1), tr(2, 2), tr(2, 3)
         };
-        instanceInfo[mBLAS.size()].push_back({ transformationMatrix, 1 });
-        mBLAS.push_back(std::make_unique<AccelerationStructure>(device, commandPool, accelerationStructureInitData));
+        tlasInitData.transformMatrices.push_back(transformationMatrix);
+        tlasInitData.blasDeviceAddresses.push_back({ pSphereBLAS->getDeviceAddress(), 1 });
+        tlasInitData.primitiveCount++;
 
         for (ptr_size i = 0; i < proceduralSpheres.size(); ++i)
         {
@@ -154,38 +221,29 @@ bool SimpleGUI::onInitialize()
 
             for (ptr_size j = 0; j < sphere.transformationMatrices.size(); ++j)
             {
-                auto instance         = std::make_unique<InstanceData>();
-                instance->materialId  = sphere.materialId;
-                instance->lightId     = sphere.lightId;
-                instance->objectIndex = -1;
-                instance->sphereId    = i;
+                auto instance          = std::make_unique<InstanceData>();
+                instance->materialId   = sphere.materialId;
+                instance->lightId      = sphere.lightId;
+                instance->objectIndex  = -1;
+                instance->sphereId     = i;
+                instance->flags        = 0;
                 mInstances.push_back(std::move(instance));
             }
         }
     }
 
-    accelerationStructureInitData.type           = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
-    accelerationStructureInitData.primitiveCount = 0;
-    uint32 i                                     = 0;
-    for (const std::unique_ptr<AccelerationStructure>& blas : mBLAS)
+    // nothing is rendered until the first geometry is ready
+    if (tlasInitData.primitiveCount > 0)
     {
-        for (const auto& [transformationMatrix, hitGroup] : instanceInfo[i])
-        {
-            accelerationStructureInitData.transformMatrices.push_back(transformationMatrix);
-            accelerationStructureInitData.blasDeviceAddresses.push_back({ blas->getDeviceAddress(), hitGroup });
-            accelerationStructureInitData.primitiveCount++;
-        }
-        i++;
+        pTLAS = std::make_unique<AccelerationStructure>(device, commandPool, tlasInitData);
+        buildBytes += pTLAS->getSize();
+    }
+    else
+    {
+        pTLAS.reset();
     }
-    pTLAS = std::make_unique<AccelerationStructure>(device, commandPool, accelerationStructureInitData);
-
-    // camera
-    float aspect = static_cast<float>(getWindowWidth()) / static_cast<float>(getWindowHeight());
-    pCamera      = std::make_unique<Camera>(aspect, 45.0f, 0.02f, 20.0f, 0.0f, 0.0f, vec3(0.0f, 2.0f, 8.0f), vec3(0.0f, 2.0f, 0.0f), getInput());
-
-    mAccumulationFrame = 0;
 
-    return true;
+    pScene->addLoadTiming(ESceneLoadPhase::accelerationStructureBuild, static_cast<double>(buildTimer.elapsedMicroseconds().count()) * 0.001, buildBytes);
 }
 
 bool SimpleGUI::onShutdown()
@@ -205,6 +263,22 @@ void SimpleGUI::onUpdate(float dt)
         mRecreateRTData = true;
     }
 
+    if (pScene->isLoading())
+    {
+        // picking up finished meshes restarts the accumulation, so it is not done every frame
+        mSceneUpdateTimer += dt;
+        if (mSceneUpdateTimer >= kSceneUpdateInterval || !pTLAS)
+        {
+            mSceneUpdateTimer = 0.0f;
+            if (pScene->updateProgressiveLoad(getDevice(), getCommandPool()))
+            {
+                buildAccelerationStructures();
+                mRecreateRTData    = true;
+                mAccumulationFrame = 0;
+            }
+        }
+    }
+
     if (mRecreateRTData)
     {
         recreateRTData();
@@ -213,7 +287,7 @@ void SimpleGUI::onUpdate(float dt)
 
     bool cameraMoved = pCamera->update(dt);
 
-    if (cameraMoved)
+    if (cameraMoved && pRaytracingPipeline)
     {
         CameraDataRT cameraDataRT;
         cameraDataRT.inverseView       = pCamera->getInverseView();
@@ -238,7 +312,7 @@ void SimpleGUI::onRender(VkCommandBuffer commandBuffer, const uint32 imageIndex)
 {
     RayceApp::onRender(commandBuffer, imageIndex);
 
-    if (mAccumulationFrame >= mMaxSamples)
+    if (!pRaytracingPipeline || mAccumulationFrame >= mMaxSamples)
     {
         return;
     }
@@ -336,7 +410,7 @@ void SimpleGUI::onImGuiRender(VkCommandBuffer commandBuffer, const uint32 imageI
 
     bool cameraChanged = pCamera->onImGuiRender();
 
-    if (cameraChanged)
+    if (cameraChanged && pRaytracingPipeline)
     {
         CameraDataRT cameraDataRT;
         cameraDataRT.inverseView       = pCamera->getInverseView();
@@ -386,7 +460,16 @@ void SimpleGUI::onImGuiRender(VkCommandBuffer commandBuffer, const uint32 imageI
     {
         mRecreateRTData = mViewportChange;
         mViewportChange = false;
-        ImGui::Image(mImguiVkSet, viewportPanelSize);
+        if (pRaytracingPipeline)
+        {
+            ImGui::Image(mImguiVkSet, viewportPanelSize);
+        }
+        else
+        {
+            ImGui::Dummy(viewportPanelSize);
+            ImGui::SetCursorPos(ImVec2(viewportPanelSize.x * 0.5f - 50.0f, viewportPanelSize.y * 0.5f));
+            ImGui::Text("Loading scene...");
+        }
         // FIXME: Lets hope, that imgui gets fixed soon so input can be disabled for docked windows...
         ImVec2 rectMin      = ImGui::GetItemRectMin();
         ImVec2 rectMax      = ImGui::GetItemRectMax();
@@ -449,7 +532,7 @@ void SimpleGUI::onImGuiRender(VkCommandBuffer commandBuffer, const uint32 imageI
     ImGui::Separator();
 
     // ImGui::InputText("Filename");
-    if (ImGui::Button("Store Snapshot"))
+    if (ImGui::Button("Store Snapshot") && pRaytracingPipeline)
     {
         // download image from device and store as bmp
 
@@ -501,7 +584,13 @@ void SimpleGUI::recreateRTData()
     cameraDataRT.pbData.y()        = pCamera->getFocalDistance();
     cameraDataRT.pbData.z()        = pCamera->getNear();
     cameraDataRT.pbData.w()        = pCamera->getFar();
-    pRaytracingPipeline.reset(new RaytracingPipeline(device, commandPool, swapchain, pTLAS, mVertexBuffers, mIndexBuffers, cameraDataRT, static_cast<uint32>(textureViews.size()), pRaytracingTargetView, swapchain->getImageCount()));
+    if (!pTLAS)
+    {
+        pRaytracingPipeline.reset();
+        return;
+    }
+
+    pRaytracingPipeline.reset(new RaytracingPipeline(device, commandPool, swapchain, pTLAS, mVertexBuffers, mIndexBuffers, mAttributeBuffers, mTriangleMaterialBuffers, cameraDataRT, static_cast<uint32>(textureViews.size()), pRaytracingTargetView, swapchain->getImageCount()));
 
     pRaytracingPipeline->updateModelData(device, mInstances, mSpheres, pScene->getMaterials(), pScene->getLights(), textureViews, samplers);
 }
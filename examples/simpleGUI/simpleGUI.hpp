@@ -26,6 +26,7 @@ namespace rayce
 
     private:
         void recreateRTData();
+        void buildAccelerationStructures();
 
         std::unique_ptr<class RaytracingPipeline> pRaytracingPipeline;
         std::unique_ptr<class RayceScene> pScene;
@@ -39,15 +40,19 @@ namespace rayce
         bool mReInitialize;
         bool mRecreateRTData;
         uvec2 mViewportPanelSize;
+        float mSceneUpdateTimer;
 
         std::unique_ptr<class Sampler> pDefaultSampler;
 
         std::vector<struct Sphere> mSpheres;
         std::unique_ptr<class Buffer> mAABBBuffer;
         std::vector<std::unique_ptr<class AccelerationStructure>> mBLAS;
+        std::unique_ptr<class AccelerationStructure> pSphereBLAS;
         std::unique_ptr<class AccelerationStructure> pTLAS;
         std::vector<VkBuffer> mVertexBuffers;
         std::vector<VkBuffer> mIndexBuffers;
+        std::vector<VkBuffer> mAttributeBuffers;
+        std::vector<VkBuffer> mTriangleMaterialBuffers;
 
         std::vector<std::unique_ptr<struct InstanceData>> mInstances;
 
@@ -0,0 +1,168 @@
+/// @file      spectrumBenchmark.cpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#include <core.hpp>
+#include <core/spectrum.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace rayce;
+
+// number of passes over all files for the sequential parsers, the fastest pass is reported
+static constexpr uint32 kPassCount = 10;
+
+// the stream based parser spd files were read with before, kept as the baseline
+static LinearInterpolatedSpectrum parseWithStreams(const str& filename)
+{
+    std::vector<float> wavelengths;
+    std::vector<float> values;
+
+    std::ifstream input(filename);
+    str line;
+    while (std::getline(input, line))
+    {
+        line = trim(line);
+        if (line.length() == 0 || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        float lambda, value;
+        if (!(iss >> lambda >> value))
+        {
+            break;
+        }
+
+        wavelengths.push_back(lambda);
+        values.push_back(value);
+    }
+
+    return LinearInterpolatedSpectrum(wavelengths, values);
+}
+
+// the rgb projection with one virtual evaluate call per wavelength and matching function, kept as the baseline
+static vec3 projectPerWavelength(const Spectrum& spectrum)
+{
+    vec3 xyz(0.0, 0.0, 0.0);
+    vec2 range      = spectrum.range();
+    float minLambda = std::max(range.x(), Spectra::CIEY.range().x());
+    float maxLambda = std::min(range.y(), Spectra::CIEY.range().y());
+    for (float lambda = minLambda; lambda <= maxLambda; lambda += 1.0)
+    {
+        float value = spectrum.evaluate(lambda);
+        xyz += value * vec3(Spectra::CIEX.evaluate(lambda), Spectra::CIEY.evaluate(lambda), Spectra::CIEZ.evaluate(lambda));
+    }
+    return XYZtoRGBRec709(xyz / Spectra::CIEYIntegral);
+}
+
+template <typename Projection>
+static double fastestProjection(const std::vector<LinearInterpolatedSpectrum>& spectra, const Projection& projection)
+{
+    double fastest = std::numeric_limits<double>::max();
+    for (uint32 pass = 0; pass < kPassCount; ++pass)
+    {
+        Timer timer;
+        timer.start();
+        vec3 sum(0.0, 0.0, 0.0);
+        for (const LinearInterpolatedSpectrum& spectrum : spectra)
+        {
+            sum += projection(spectrum);
+        }
+        RAYCE_UNUSED(sum);
+        fastest = std::min(fastest, static_cast<double>(timer.elapsedMicroseconds().count()) / 1000.0);
+    }
+    return fastest;
+}
+
+template <typename Parser>
+static double fastestPass(const std::vector<str>& filenames, const Parser& parser)
+{
+    double fastest = std::numeric_limits<double>::max();
+    for (uint32 pass = 0; pass < kPassCount; ++pass)
+    {
+        Timer timer;
+        timer.start();
+        for (const str& filename : filenames)
+        {
+            LinearInterpolatedSpectrum spectrum = parser(filename);
+            RAYCE_UNUSED(spectrum);
+        }
+        fastest = std::min(fastest, static_cast<double>(timer.elapsedMicroseconds().count()) / 1000.0);
+    }
+    return fastest;
+}
+
+int main(int argc, char** argv)
+{
+    const str directory = argc > 1 ? argv[1] : "assets/spectra";
+
+    std::vector<str> filenames;
+    uint64 bytes = 0;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".spd")
+        {
+            filenames.push_back(entry.path().generic_string());
+            bytes += entry.file_size();
+        }
+    }
+    if (error || filenames.empty())
+    {
+        RAYCE_LOG_ERROR("No spd files found in %s!", directory.c_str());
+        return 1;
+    }
+
+    // both parsers and both projections have to agree before their timings mean anything
+    std::vector<LinearInterpolatedSpectrum> spectra;
+    for (const str& filename : filenames)
+    {
+        LinearInterpolatedSpectrum reference = parseWithStreams(filename);
+        LinearInterpolatedSpectrum mapped    = LinearInterpolatedSpectrum::fromFile(filename);
+        if (reference.empty() != mapped.empty() || (!reference.empty() && (reference.range() != mapped.range() || spectrumToRGB(reference) != spectrumToRGB(mapped))))
+        {
+            RAYCE_LOG_ERROR("Parsers disagree on %s!", filename.c_str());
+            return 1;
+        }
+        if (mapped.empty())
+        {
+            continue;
+        }
+
+        vec3 perWavelength = projectPerWavelength(mapped);
+        if ((perWavelength - spectrumToRGB(mapped)).norm() > 1e-5 * std::max(1.0f, perWavelength.norm()))
+        {
+            RAYCE_LOG_ERROR("Projections disagree on %s!", filename.c_str());
+            return 1;
+        }
+        spectra.push_back(std::move(mapped));
+    }
+
+    const double streamMilliseconds = fastestPass(filenames, parseWithStreams);
+    const double mappedMilliseconds = fastestPass(filenames, LinearInterpolatedSpectrum::fromFile);
+
+    const double perWavelengthMilliseconds = fastestProjection(spectra, projectPerWavelength);
+    const double batchedMilliseconds       = fastestProjection(spectra, [](const LinearInterpolatedSpectrum& spectrum)
+                                                               { return spectrumToRGB(spectrum); });
+
+    // the preload fills the process wide cache, so only the first call does any work
+    Timer timer;
+    timer.start();
+    const uint32 preloaded           = Spectra::preloadFileSpectra(directory);
+    const double preloadMilliseconds = static_cast<double>(timer.elapsedMicroseconds().count()) / 1000.0;
+
+    const double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    RAYCE_LOG_INFO("%llu spd files, %.2f MiB", static_cast<uint64>(filenames.size()), megabytes);
+    RAYCE_LOG_INFO("ifstream + istringstream:  %8.3f ms  %8.1f MiB/s", streamMilliseconds, megabytes / (streamMilliseconds / 1000.0));
+    RAYCE_LOG_INFO("mapped + from_chars:       %8.3f ms  %8.1f MiB/s", mappedMilliseconds, megabytes / (mappedMilliseconds / 1000.0));
+    RAYCE_LOG_INFO("rgb projection per wavelength: %8.3f ms  batched: %8.3f ms (%llu spectra)", perWavelengthMilliseconds, batchedMilliseconds, static_cast<uint64>(spectra.size()));
+    RAYCE_LOG_INFO("parallel preload (%u read): %8.3f ms  %8.1f MiB/s (includes rgb projection)", preloaded, preloadMilliseconds, megabytes / (preloadMilliseconds / 1000.0));
+
+    return 0;
+}
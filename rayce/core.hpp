@@ -18,5 +18,7 @@
 #include "core/inputCodes.hpp"
 #include "core/input.hpp"
 #include "core/timer.hpp"
+#include "core/parallel.hpp"
+#include "core/mappedFile.hpp"
 
 #endif // CORE_HPP
\ No newline at end of file
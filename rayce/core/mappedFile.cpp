@@ -0,0 +1,99 @@
+/// @file      mappedFile.cpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#include <core/mappedFile.hpp>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace rayce;
+
+MappedFile::MappedFile(const str& filename)
+    : mData(nullptr)
+    , mSize(0)
+    , mMappingHandle(nullptr)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        RAYCE_LOG_ERROR("Can not map %s!", filename.c_str());
+        return;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        RAYCE_LOG_ERROR("Can not map %s!", filename.c_str());
+        CloseHandle(mapping);
+        return;
+    }
+
+    mData          = static_cast<const byte*>(data);
+    mSize          = static_cast<ptr_size>(fileSize.QuadPart);
+    mMappingHandle = mapping;
+#else
+    int32 file = open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return;
+    }
+
+    void* data = mmap(nullptr, static_cast<ptr_size>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        RAYCE_LOG_ERROR("Can not map %s!", filename.c_str());
+        return;
+    }
+
+    mData = static_cast<const byte*>(data);
+    mSize = static_cast<ptr_size>(fileStat.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if (!mData)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(mData);
+    CloseHandle(mMappingHandle);
+#else
+    munmap(const_cast<byte*>(mData), mSize);
+#endif
+}
@@ -0,0 +1,53 @@
+/// @file      mappedFile.hpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#pragma once
+
+#ifndef RAYCE_MAPPED_FILE_HPP
+#define RAYCE_MAPPED_FILE_HPP
+
+namespace rayce
+{
+    /// @brief Read only memory mapping of a whole file.
+    class RAYCE_API_EXPORT MappedFile
+    {
+    public:
+        RAYCE_DISABLE_COPY_MOVE(MappedFile)
+
+        /// @brief Maps the file, check @a valid() afterwards.
+        /// @param[in] filename The file to map.
+        MappedFile(const str& filename);
+        ~MappedFile();
+
+        /// @brief Checks if the mapping succeeded.
+        /// @return True if the file is mapped, else False.
+        bool valid() const
+        {
+            return mData != nullptr;
+        }
+
+        /// @brief Retrieves the mapped file content.
+        /// @return The pointer to the first byte of the file.
+        const byte* getData() const
+        {
+            return mData;
+        }
+
+        /// @brief Retrieves the size of the mapped file.
+        /// @return The size of the file in bytes.
+        ptr_size getSize() const
+        {
+            return mSize;
+        }
+
+    private:
+        const byte* mData;
+        ptr_size mSize;
+        void* mMappingHandle;
+    };
+} // namespace rayce
+
+#endif // RAYCE_MAPPED_FILE_HPP
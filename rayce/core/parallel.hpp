@@ -0,0 +1,120 @@
+/// @file      parallel.hpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#pragma once
+
+#ifndef RAYCE_PARALLEL_HPP
+#define RAYCE_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <core/types.hpp>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace rayce
+{
+    /// @brief Retrieves the number of worker threads used for parallel work.
+    /// @return The number of hardware threads, at least one.
+    inline uint32 getWorkerCount()
+    {
+        return std::max(1u, static_cast<uint32>(std::thread::hardware_concurrency()));
+    }
+
+    /// @brief Checks if the calling thread is running work of a @a parallelFor.
+    /// @return A reference to the flag of the calling thread, True while it processes indices of a @a parallelFor.
+    inline bool& insideParallelFor()
+    {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    /// @brief Executes a function for every index in [0, count) on a pool of worker threads.
+    /// @details Indices are fetched dynamically, so the order of execution is not deterministic.
+    /// Results should be written to pre-sized per-index storage to keep the output deterministic.
+    /// With a single worker or when called from the function of another @a parallelFor everything runs on the calling thread,
+    /// so nested calls do not multiply the thread count. An exception thrown by the function is rethrown on the calling thread
+    /// after all workers finished, the remaining indices are skipped.
+    /// @param[in] count The number of indices to process.
+    /// @param[in] func The function to call with each index.
+    /// @param[in] maxWorkers The maximum number of workers to use, 0 to use @a getWorkerCount().
+    template <typename Func>
+    void parallelFor(ptr_size count, const Func& func, uint32 maxWorkers = 0)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        uint32 workerCount = maxWorkers == 0 ? getWorkerCount() : maxWorkers;
+        workerCount        = static_cast<uint32>(std::min<ptr_size>(workerCount, count));
+
+        if (workerCount <= 1 || insideParallelFor())
+        {
+            for (ptr_size i = 0; i < count; ++i)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<ptr_size> next{ 0 };
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        auto work = [&]()
+        {
+            insideParallelFor() = true;
+            try
+            {
+                for (ptr_size i = next++; i < count; i = next++)
+                {
+                    func(i);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure)
+                {
+                    failure = std::current_exception();
+                }
+                next = count;
+            }
+            insideParallelFor() = false;
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount - 1);
+        try
+        {
+            for (uint32 w = 0; w < workerCount - 1; ++w)
+            {
+                workers.emplace_back(work);
+            }
+        }
+        catch (const std::system_error&)
+        {
+            // no more threads available, the ones already started and the calling thread do the work
+        }
+
+        work();
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+} // namespace rayce
+
+#endif // RAYCE_PARALLEL_HPP
@@ -5,7 +5,13 @@
 /// @copyright Apache License 2.0
 
 #include "spectrum.hpp"
-#include <fstream>
+#include <charconv>
+#include <core/mappedFile.hpp>
+#include <core/parallel.hpp>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
 
 #include "spectrum.inl"
 
@@ -15,37 +21,58 @@ const DenseSpectrum Spectra::CIEX(360.0, 830.0, CIE_X, CIESampleCount);
 const DenseSpectrum Spectra::CIEY(360.0, 830.0, CIE_Y, CIESampleCount);
 const DenseSpectrum Spectra::CIEZ(360.0, 830.0, CIE_Z, CIESampleCount);
 
+static const char* skipSpdSpaces(const char* begin, const char* end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+static const char* parseSpdFloat(const char* begin, const char* end, float& value)
+{
+    begin = skipSpdSpaces(begin, end);
+    if (begin < end && *begin == '+')
+    {
+        ++begin;
+    }
+    std::from_chars_result result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
 LinearInterpolatedSpectrum LinearInterpolatedSpectrum::fromFile(const str& filename)
 {
-    // FIXME: Implement!
     std::vector<float> wavelengths;
     std::vector<float> values;
 
-    std::ifstream input(filename);
-    if (input.bad() || input.fail())
+    MappedFile input(filename);
+    if (!input.valid())
     {
         RAYCE_LOG_ERROR("Can not open spd file %s", filename.c_str());
         LinearInterpolatedSpectrum spectrum = LinearInterpolatedSpectrum(wavelengths, values);
         return spectrum;
     }
 
-    str line;
-    while (true)
+    // every line holds a wavelength and a value, empty lines and comments are skipped, parsing stops at the first malformed line
+    const char* cursor = reinterpret_cast<const char*>(input.getData());
+    const char* end    = cursor + input.getSize();
+    while (cursor < end)
     {
-        if (!std::getline(input, line))
-        {
-            break;
-        }
+        const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        lineEnd             = lineEnd ? lineEnd : end;
+        const char* begin   = skipSpdSpaces(cursor, lineEnd);
+        cursor              = lineEnd + 1;
 
-        line = trim(line);
-        if (line.length() == 0 || line[0] == '#')
+        if (begin == lineEnd || *begin == '#')
         {
             continue;
         }
 
-        std::istringstream iss(line);
         float lambda, value;
-        if (!(iss >> lambda >> value))
+        begin = parseSpdFloat(begin, lineEnd, lambda);
+        begin = begin ? parseSpdFloat(begin, lineEnd, value) : nullptr;
+        if (!begin)
         {
             break;
         }
@@ -82,123 +109,265 @@ LinearInterpolatedSpectrum LinearInterpolatedSpectrum::fromInterleaved(const flo
     return spectrum;
 }
 
-static const std::unordered_map<str, LinearInterpolatedSpectrum> namedSpectra{
-    { "glass-BK7", LinearInterpolatedSpectrum::fromInterleaved(GlassBK7_eta, 29, false) },
-    { "glass-BAF10", LinearInterpolatedSpectrum::fromInterleaved(GlassBAF10_eta, 27, false) },
-    { "glass-FK51A", LinearInterpolatedSpectrum::fromInterleaved(GlassFK51A_eta, 29, false) },
-    { "glass-LASF9", LinearInterpolatedSpectrum::fromInterleaved(GlassLASF9_eta, 26, false) },
-    { "glass-F5", LinearInterpolatedSpectrum::fromInterleaved(GlassSF5_eta, 26, false) },
-    { "glass-F10", LinearInterpolatedSpectrum::fromInterleaved(GlassSF10_eta, 26, false) },
-    { "glass-F11", LinearInterpolatedSpectrum::fromInterleaved(GlassSF11_eta, 26, false) },
-
-    { "metal-Ag-eta", LinearInterpolatedSpectrum::fromInterleaved(Ag_eta, 56, false) },
-    { "metal-Ag-k", LinearInterpolatedSpectrum::fromInterleaved(Ag_k, 56, false) },
-    { "metal-Al-eta", LinearInterpolatedSpectrum::fromInterleaved(Al_eta, 56, false) },
-    { "metal-Al-k", LinearInterpolatedSpectrum::fromInterleaved(Al_k, 56, false) },
-    { "metal-Au-eta", LinearInterpolatedSpectrum::fromInterleaved(Au_eta, 56, false) },
-    { "metal-Au-k", LinearInterpolatedSpectrum::fromInterleaved(Au_k, 56, false) },
-    { "metal-Cu-eta", LinearInterpolatedSpectrum::fromInterleaved(Cu_eta, 56, false) },
-    { "metal-Cu-k", LinearInterpolatedSpectrum::fromInterleaved(Cu_k, 56, false) },
-    { "metal-CuZn-eta", LinearInterpolatedSpectrum::fromInterleaved(CuZn_eta, 61, false) },
-    { "metal-CuZn-k", LinearInterpolatedSpectrum::fromInterleaved(CuZn_k, 61, false) },
-    { "metal-MgO-eta", LinearInterpolatedSpectrum::fromInterleaved(MgO_eta, 30, false) },
-    { "metal-MgO-k", LinearInterpolatedSpectrum::fromInterleaved(MgO_k, 30, false) },
-    { "metal-TiO2-eta", LinearInterpolatedSpectrum::fromInterleaved(TiO2_eta, 34, false) },
-    { "metal-TiO2-k", LinearInterpolatedSpectrum::fromInterleaved(TiO2_k, 34, false) },
-
-    { "stdillum-A", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_A, 107, true) },
-    { "stdillum-D50", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_D5000, 107, true) },
-    { "stdillum-D65", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_D6500, 107, true) },
-    { "stdillum-F1", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F1, 81, true) },
-    { "stdillum-F2", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F2, 81, true) },
-    { "stdillum-F3", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F3, 81, true) },
-    { "stdillum-F4", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F4, 81, true) },
-    { "stdillum-F5", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F5, 81, true) },
-    { "stdillum-F6", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F6, 81, true) },
-    { "stdillum-F7", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F7, 81, true) },
-    { "stdillum-F8", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F8, 81, true) },
-    { "stdillum-F9", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F9, 81, true) },
-    { "stdillum-F10", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F10, 81, true) },
-    { "stdillum-F11", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F11, 81, true) },
-    { "stdillum-F12", LinearInterpolatedSpectrum::fromInterleaved(CIE_Illum_F12, 81, true) },
-
-    { "illum-acesD60", LinearInterpolatedSpectrum::fromInterleaved(ACES_Illum_D60, 107, true) },
-
-    { "canon_eos_100d_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_100d_r, 35, false) },
-    { "canon_eos_100d_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_100d_g, 35, false) },
-    { "canon_eos_100d_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_100d_b, 35, false) },
-
-    { "canon_eos_1dx_mkii_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_1dx_mkii_r, 35, false) },
-    { "canon_eos_1dx_mkii_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_1dx_mkii_g, 35, false) },
-    { "canon_eos_1dx_mkii_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_1dx_mkii_b, 35, false) },
-
-    { "canon_eos_200d_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_200d_r, 35, false) },
-    { "canon_eos_200d_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_200d_g, 35, false) },
-    { "canon_eos_200d_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_200d_b, 35, false) },
-
-    { "canon_eos_200d_mkii_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_200d_mkii_r, 35, false) },
-    { "canon_eos_200d_mkii_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_200d_mkii_g, 35, false) },
-    { "canon_eos_200d_mkii_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_200d_mkii_b, 35, false) },
-
-    { "canon_eos_5d_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_r, 35, false) },
-    { "canon_eos_5d_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_g, 35, false) },
-    { "canon_eos_5d_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_b, 35, false) },
-
-    { "canon_eos_5d_mkii_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkii_r, 35, false) },
-    { "canon_eos_5d_mkii_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkii_g, 35, false) },
-    { "canon_eos_5d_mkii_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkii_b, 35, false) },
-
-    { "canon_eos_5d_mkiii_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkiii_r, 35, false) },
-    { "canon_eos_5d_mkiii_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkiii_g, 35, false) },
-    { "canon_eos_5d_mkiii_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkiii_b, 35, false) },
-
-    { "canon_eos_5d_mkiv_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkiv_r, 35, false) },
-    { "canon_eos_5d_mkiv_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkiv_g, 35, false) },
-    { "canon_eos_5d_mkiv_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5d_mkiv_b, 35, false) },
-
-    { "canon_eos_5ds_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5ds_r, 35, false) },
-    { "canon_eos_5ds_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5ds_g, 35, false) },
-    { "canon_eos_5ds_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_5ds_b, 35, false) },
-
-    { "canon_eos_m_r", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_m_r, 35, false) },
-    { "canon_eos_m_g", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_m_g, 35, false) },
-    { "canon_eos_m_b", LinearInterpolatedSpectrum::fromInterleaved(canon_eos_m_b, 35, false) },
-
-    { "hasselblad_l1d_20c_r", LinearInterpolatedSpectrum::fromInterleaved(hasselblad_l1d_20c_r, 35, false) },
-    { "hasselblad_l1d_20c_g", LinearInterpolatedSpectrum::fromInterleaved(hasselblad_l1d_20c_g, 35, false) },
-    { "hasselblad_l1d_20c_b", LinearInterpolatedSpectrum::fromInterleaved(hasselblad_l1d_20c_b, 35, false) },
-
-    { "nikon_d810_r", LinearInterpolatedSpectrum::fromInterleaved(nikon_d810_r, 35, false) },
-    { "nikon_d810_g", LinearInterpolatedSpectrum::fromInterleaved(nikon_d810_g, 35, false) },
-    { "nikon_d810_b", LinearInterpolatedSpectrum::fromInterleaved(nikon_d810_b, 35, false) },
-
-    { "nikon_d850_r", LinearInterpolatedSpectrum::fromInterleaved(nikon_d850_r, 35, false) },
-    { "nikon_d850_g", LinearInterpolatedSpectrum::fromInterleaved(nikon_d850_g, 35, false) },
-    { "nikon_d850_b", LinearInterpolatedSpectrum::fromInterleaved(nikon_d850_b, 35, false) },
-
-    { "sony_ilce_6400_r", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_6400_r, 35, false) },
-    { "sony_ilce_6400_g", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_6400_g, 35, false) },
-    { "sony_ilce_6400_b", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_6400_b, 35, false) },
-
-    { "sony_ilce_7m3_r", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_7m3_r, 35, false) },
-    { "sony_ilce_7m3_g", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_7m3_g, 35, false) },
-    { "sony_ilce_7m3_b", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_7m3_b, 35, false) },
-
-    { "sony_ilce_7rm3_r", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_7rm3_r, 35, false) },
-    { "sony_ilce_7rm3_g", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_7rm3_g, 35, false) },
-    { "sony_ilce_7rm3_b", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_7rm3_b, 35, false) },
-
-    { "sony_ilce_9_r", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_9_r, 35, false) },
-    { "sony_ilce_9_g", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_9_g, 35, false) },
-    { "sony_ilce_9_b", LinearInterpolatedSpectrum::fromInterleaved(sony_ilce_9_b, 35, false) }
+namespace
+{
+    struct NamedSpectrumEntry
+    {
+        std::string_view name;
+        const float* interleaved;
+        ptr_size count;
+        bool normalize;
+    };
+
+    template <ptr_size N>
+    constexpr NamedSpectrumEntry namedSpectrum(std::string_view name, const float (&interleaved)[N], bool normalize = false)
+    {
+        return { name, interleaved, N / 2, normalize };
+    }
+} // namespace
+
+// the table only references the interleaved arrays in read only data, nothing is constructed before main
+static constexpr NamedSpectrumEntry kNamedSpectra[] = {
+    namedSpectrum("glass-BK7", GlassBK7_eta),
+    namedSpectrum("glass-BAF10", GlassBAF10_eta),
+    namedSpectrum("glass-FK51A", GlassFK51A_eta),
+    namedSpectrum("glass-LASF9", GlassLASF9_eta),
+    namedSpectrum("glass-F5", GlassSF5_eta),
+    namedSpectrum("glass-F10", GlassSF10_eta),
+    namedSpectrum("glass-F11", GlassSF11_eta),
+
+    namedSpectrum("metal-Ag-eta", Ag_eta),
+    namedSpectrum("metal-Ag-k", Ag_k),
+    namedSpectrum("metal-Al-eta", Al_eta),
+    namedSpectrum("metal-Al-k", Al_k),
+    namedSpectrum("metal-Au-eta", Au_eta),
+    namedSpectrum("metal-Au-k", Au_k),
+    namedSpectrum("metal-Cu-eta", Cu_eta),
+    namedSpectrum("metal-Cu-k", Cu_k),
+    namedSpectrum("metal-CuZn-eta", CuZn_eta),
+    namedSpectrum("metal-CuZn-k", CuZn_k),
+    namedSpectrum("metal-MgO-eta", MgO_eta),
+    namedSpectrum("metal-MgO-k", MgO_k),
+    namedSpectrum("metal-TiO2-eta", TiO2_eta),
+    namedSpectrum("metal-TiO2-k", TiO2_k),
+
+    namedSpectrum("stdillum-A", CIE_Illum_A, true),
+    namedSpectrum("stdillum-D50", CIE_Illum_D5000, true),
+    namedSpectrum("stdillum-D65", CIE_Illum_D6500, true),
+    namedSpectrum("stdillum-F1", CIE_Illum_F1, true),
+    namedSpectrum("stdillum-F2", CIE_Illum_F2, true),
+    namedSpectrum("stdillum-F3", CIE_Illum_F3, true),
+    namedSpectrum("stdillum-F4", CIE_Illum_F4, true),
+    namedSpectrum("stdillum-F5", CIE_Illum_F5, true),
+    namedSpectrum("stdillum-F6", CIE_Illum_F6, true),
+    namedSpectrum("stdillum-F7", CIE_Illum_F7, true),
+    namedSpectrum("stdillum-F8", CIE_Illum_F8, true),
+    namedSpectrum("stdillum-F9", CIE_Illum_F9, true),
+    namedSpectrum("stdillum-F10", CIE_Illum_F10, true),
+    namedSpectrum("stdillum-F11", CIE_Illum_F11, true),
+    namedSpectrum("stdillum-F12", CIE_Illum_F12, true),
+
+    namedSpectrum("illum-acesD60", ACES_Illum_D60, true),
+
+    namedSpectrum("canon_eos_100d_r", canon_eos_100d_r),
+    namedSpectrum("canon_eos_100d_g", canon_eos_100d_g),
+    namedSpectrum("canon_eos_100d_b", canon_eos_100d_b),
+
+    namedSpectrum("canon_eos_1dx_mkii_r", canon_eos_1dx_mkii_r),
+    namedSpectrum("canon_eos_1dx_mkii_g", canon_eos_1dx_mkii_g),
+    namedSpectrum("canon_eos_1dx_mkii_b", canon_eos_1dx_mkii_b),
+
+    namedSpectrum("canon_eos_200d_r", canon_eos_200d_r),
+    namedSpectrum("canon_eos_200d_g", canon_eos_200d_g),
+    namedSpectrum("canon_eos_200d_b", canon_eos_200d_b),
+
+    namedSpectrum("canon_eos_200d_mkii_r", canon_eos_200d_mkii_r),
+    namedSpectrum("canon_eos_200d_mkii_g", canon_eos_200d_mkii_g),
+    namedSpectrum("canon_eos_200d_mkii_b", canon_eos_200d_mkii_b),
+
+    namedSpectrum("canon_eos_5d_r", canon_eos_5d_r),
+    namedSpectrum("canon_eos_5d_g", canon_eos_5d_g),
+    namedSpectrum("canon_eos_5d_b", canon_eos_5d_b),
+
+    namedSpectrum("canon_eos_5d_mkii_r", canon_eos_5d_mkii_r),
+    namedSpectrum("canon_eos_5d_mkii_g", canon_eos_5d_mkii_g),
+    namedSpectrum("canon_eos_5d_mkii_b", canon_eos_5d_mkii_b),
+
+    namedSpectrum("canon_eos_5d_mkiii_r", canon_eos_5d_mkiii_r),
+    namedSpectrum("canon_eos_5d_mkiii_g", canon_eos_5d_mkiii_g),
+    namedSpectrum("canon_eos_5d_mkiii_b", canon_eos_5d_mkiii_b),
+
+    namedSpectrum("canon_eos_5d_mkiv_r", canon_eos_5d_mkiv_r),
+    namedSpectrum("canon_eos_5d_mkiv_g", canon_eos_5d_mkiv_g),
+    namedSpectrum("canon_eos_5d_mkiv_b", canon_eos_5d_mkiv_b),
+
+    namedSpectrum("canon_eos_5ds_r", canon_eos_5ds_r),
+    namedSpectrum("canon_eos_5ds_g", canon_eos_5ds_g),
+    namedSpectrum("canon_eos_5ds_b", canon_eos_5ds_b),
+
+    namedSpectrum("canon_eos_m_r", canon_eos_m_r),
+    namedSpectrum("canon_eos_m_g", canon_eos_m_g),
+    namedSpectrum("canon_eos_m_b", canon_eos_m_b),
+
+    namedSpectrum("hasselblad_l1d_20c_r", hasselblad_l1d_20c_r),
+    namedSpectrum("hasselblad_l1d_20c_g", hasselblad_l1d_20c_g),
+    namedSpectrum("hasselblad_l1d_20c_b", hasselblad_l1d_20c_b),
+
+    namedSpectrum("nikon_d810_r", nikon_d810_r),
+    namedSpectrum("nikon_d810_g", nikon_d810_g),
+    namedSpectrum("nikon_d810_b", nikon_d810_b),
+
+    namedSpectrum("nikon_d850_r", nikon_d850_r),
+    namedSpectrum("nikon_d850_g", nikon_d850_g),
+    namedSpectrum("nikon_d850_b", nikon_d850_b),
+
+    namedSpectrum("sony_ilce_6400_r", sony_ilce_6400_r),
+    namedSpectrum("sony_ilce_6400_g", sony_ilce_6400_g),
+    namedSpectrum("sony_ilce_6400_b", sony_ilce_6400_b),
+
+    namedSpectrum("sony_ilce_7m3_r", sony_ilce_7m3_r),
+    namedSpectrum("sony_ilce_7m3_g", sony_ilce_7m3_g),
+    namedSpectrum("sony_ilce_7m3_b", sony_ilce_7m3_b),
+
+    namedSpectrum("sony_ilce_7rm3_r", sony_ilce_7rm3_r),
+    namedSpectrum("sony_ilce_7rm3_g", sony_ilce_7rm3_g),
+    namedSpectrum("sony_ilce_7rm3_b", sony_ilce_7rm3_b),
+
+    namedSpectrum("sony_ilce_9_r", sony_ilce_9_r),
+    namedSpectrum("sony_ilce_9_g", sony_ilce_9_g),
+    namedSpectrum("sony_ilce_9_b", sony_ilce_9_b)
+
 };
 
+static constexpr ptr_size kNamedSpectraCount    = std::size(kNamedSpectra);
+static_assert(kNamedSpectraCount == 88, "A named spectrum went missing from the table!");
+
+// sparse enough that a collision free seed is found after a few tries
+static constexpr uint32 kNamedSpectrumSlotCount = 1024;
+static constexpr uint32 kNoNamedSpectrumSeed    = std::numeric_limits<uint32>::max();
+
+static constexpr uint32 hashSpectrumName(std::string_view name, uint32 seed)
+{
+    uint32 hash = seed;
+    for (char c : name)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x9E3779B1u + 0x7F4A7C15u;
+    }
+    hash ^= hash >> 15;
+    return hash % kNamedSpectrumSlotCount;
+}
+
+// searches a seed mapping every name to a slot of its own, so a lookup is one hash and one string compare
+static constexpr uint32 findNamedSpectrumSeed()
+{
+    for (uint32 seed = 0; seed < 4096; ++seed)
+    {
+        bool used[kNamedSpectrumSlotCount] = {};
+        bool collision                     = false;
+        for (const NamedSpectrumEntry& entry : kNamedSpectra)
+        {
+            uint32 slot = hashSpectrumName(entry.name, seed);
+            collision   = collision || used[slot];
+            used[slot]  = true;
+        }
+        if (!collision)
+        {
+            return seed;
+        }
+    }
+    return kNoNamedSpectrumSeed;
+}
+
+static constexpr uint32 kNamedSpectrumSeed = findNamedSpectrumSeed();
+static_assert(kNamedSpectrumSeed != kNoNamedSpectrumSeed, "No perfect hash for the named spectra, increase kNamedSpectrumSlotCount!");
+
+static constexpr std::array<int16, kNamedSpectrumSlotCount> buildNamedSpectrumSlots()
+{
+    std::array<int16, kNamedSpectrumSlotCount> slots{};
+    slots.fill(-1);
+    for (ptr_size i = 0; i < kNamedSpectraCount; ++i)
+    {
+        slots[hashSpectrumName(kNamedSpectra[i].name, kNamedSpectrumSeed)] = static_cast<int16>(i);
+    }
+    return slots;
+}
+
+static constexpr std::array<int16, kNamedSpectrumSlotCount> kNamedSpectrumSlots = buildNamedSpectrumSlots();
+
 const LinearInterpolatedSpectrum* Spectra::getNamedSpectrum(const str& name)
 {
-    auto it = namedSpectra.find(name);
-    if (it == namedSpectra.end())
+    const int32 index = kNamedSpectrumSlots[hashSpectrumName(name, kNamedSpectrumSeed)];
+    if (index < 0 || kNamedSpectra[index].name != name)
     {
         return nullptr;
     }
-    return &it->second;
+
+    // every spectrum is built on its first lookup
+    static std::array<std::once_flag, kNamedSpectraCount> built;
+    static std::array<std::optional<LinearInterpolatedSpectrum>, kNamedSpectraCount> spectra;
+    std::call_once(built[index],
+                   [index]()
+                   {
+                       const NamedSpectrumEntry& entry = kNamedSpectra[index];
+                       spectra[index].emplace(LinearInterpolatedSpectrum::fromInterleaved(entry.interleaved, entry.count, entry.normalize));
+                   });
+    return &*spectra[index];
+}
+
+const Spectra::FileSpectrum& Spectra::getFileSpectrum(const str& filename, bool& read)
+{
+    // entries are never removed, so references stay valid after the lock is released
+    static std::mutex fileSpectraMutex;
+    static std::unordered_map<str, std::unique_ptr<const FileSpectrum>> fileSpectra;
+
+    // differently spelled paths to the same file share an entry
+    const str key = std::filesystem::path(filename).lexically_normal().generic_string();
+
+    {
+        std::lock_guard<std::mutex> lock(fileSpectraMutex);
+        auto it = fileSpectra.find(key);
+        if (it != fileSpectra.end())
+        {
+            read = false;
+            return *it->second;
+        }
+    }
+
+    // parsed without holding the lock, threads racing for the same file both parse it and the first insert wins
+    LinearInterpolatedSpectrum spectrum = LinearInterpolatedSpectrum::fromFile(filename);
+    vec3 rgb                            = spectrumToRGB(spectrum);
+    read                                = true;
+
+    std::lock_guard<std::mutex> lock(fileSpectraMutex);
+    auto [it, inserted] = fileSpectra.try_emplace(key, std::make_unique<const FileSpectrum>(FileSpectrum{ std::move(spectrum), rgb }));
+    return *it->second;
+}
+
+uint32 Spectra::preloadFileSpectra(const str& directory)
+{
+    std::vector<str> filenames;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".spd")
+        {
+            filenames.push_back(entry.path().generic_string());
+        }
+    }
+    if (error)
+    {
+        RAYCE_LOG_WARN("Can not preload spectra from %s!", directory.c_str());
+        return 0;
+    }
+
+    std::atomic<uint32> readCount{ 0 };
+    parallelFor(filenames.size(),
+                [&](ptr_size f)
+                {
+                    bool read;
+                    getFileSpectrum(filenames[f], read);
+                    readCount += read ? 1 : 0;
+                });
+
+    return readCount;
 }
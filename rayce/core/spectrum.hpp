@@ -14,6 +14,7 @@
 #include <core/color.hpp>
 #include <core/utils.hpp>
 #include <numeric>
+#include <span>
 
 #define SPECTRUM_SAMPLES 3 // RGB
 
@@ -27,6 +28,17 @@ namespace rayce
     public:
         virtual float evaluate(float lambda) const = 0;
 
+        // evaluates all lambdas at once, out has to be at least as large as lambdas
+        // the default falls back to the per wavelength version, dense, linear interpolated and constant spectra do it without a call per wavelength
+        virtual void evaluate(std::span<const float> lambdas, std::span<float> out) const
+        {
+            assert(out.size() >= lambdas.size());
+            for (ptr_size i = 0; i < lambdas.size(); ++i)
+            {
+                out[i] = evaluate(lambdas[i]);
+            }
+        }
+
         virtual vec2 range() const = 0;
 
         virtual bool empty() const = 0;
@@ -47,6 +59,12 @@ namespace rayce
             return mConstant;
         }
 
+        void evaluate(std::span<const float> lambdas, std::span<float> out) const override
+        {
+            assert(out.size() >= lambdas.size());
+            std::fill_n(out.begin(), lambdas.size(), mConstant);
+        }
+
         bool empty() const override
         {
             return false;
@@ -126,6 +144,22 @@ namespace rayce
             return mValues[index];
         }
 
+        void evaluate(std::span<const float> lambdas, std::span<float> out) const override
+        {
+            assert(out.size() >= lambdas.size());
+            for (ptr_size i = 0; i < lambdas.size(); ++i)
+            {
+                int index = std::lround(lambdas[i] - mRangeLambda.x());
+                out[i]    = (index < 0 || static_cast<ptr_size>(index) >= mValues.size()) ? 0.0f : mValues[index];
+            }
+        }
+
+        // the samples at 1nm steps starting at range().x()
+        std::span<const float> values() const
+        {
+            return mValues;
+        }
+
         bool empty() const override
         {
             return mValues.empty() || mValues[0] < 0.0;
@@ -201,6 +235,58 @@ namespace rayce
             return (1.0 - t) * mValues[index] + t * mValues[index + 1];
         }
 
+        void evaluate(std::span<const float> lambdas, std::span<float> out) const override
+        {
+            assert(out.size() >= lambdas.size());
+            if (mLambdas.size() < 2)
+            {
+                Spectrum::evaluate(lambdas, out);
+                return;
+            }
+
+            // lambdas are usually ascending, so the interval is found by walking on from the previous one
+            // the binary search is only needed if a lambda goes backwards
+            const ptr_size lastInterval = mLambdas.size() - 2;
+            ptr_size index              = 0;
+            ptr_size i                  = 0;
+            while (i < lambdas.size())
+            {
+                float lambda = lambdas[i];
+                if (lambda < mLambdas.front() || lambda > mLambdas.back())
+                {
+                    out[i++] = 0.0;
+                    continue;
+                }
+
+                if (lambda < mLambdas[index])
+                {
+                    index = interval(mLambdas.size(), [&](uint32 idx)
+                                     { return mLambdas[idx] <= lambda; });
+                }
+                while (index < lastInterval && mLambdas[index + 1] <= lambda)
+                {
+                    ++index;
+                }
+
+                // every following lambda inside this interval is interpolated in one branch free, vectorizable loop
+                const float lambda0 = mLambdas[index];
+                const float lambda1 = mLambdas[index + 1];
+                ptr_size end        = i + 1;
+                while (end < lambdas.size() && lambdas[end] >= lambda0 && lambdas[end] <= lambda1)
+                {
+                    ++end;
+                }
+
+                const float value0 = mValues[index];
+                const float value1 = mValues[index + 1];
+                for (; i < end; ++i)
+                {
+                    float t = (lambdas[i] - lambda0) / (lambda1 - lambda0);
+                    out[i]  = (1.0f - t) * value0 + t * value1;
+                }
+            }
+        }
+
         bool empty() const override
         {
             return mLambdas.empty();
@@ -233,6 +319,8 @@ namespace rayce
 
     class RAYCE_API_EXPORT RGBSpectrum : public Spectrum
     {
+        using Spectrum::evaluate;
+
         RGBSpectrum(const vec3 rgb)
             : mRGB(rgb)
         {
@@ -281,6 +369,8 @@ namespace rayce
             mNormalization  = 1.0 / blackbody(lambdaMax * 1e9, temperature);
         }
 
+        using Spectrum::evaluate;
+
         float evaluate(float lambda) const override
         {
             return blackbody(lambda, mTemp) * mNormalization;
@@ -319,6 +409,24 @@ namespace rayce
         float mNormalization;
     };
 
+    // the 1nm steps the inner products integrate over
+    inline std::vector<float> sampleLambdas(float minLambda, float maxLambda)
+    {
+        std::vector<float> lambdas;
+        lambdas.reserve(static_cast<ptr_size>(std::max(maxLambda - minLambda + 1.0f, 0.0f)));
+        for (float lambda = minLambda; lambda <= maxLambda; lambda += 1.0)
+        {
+            lambdas.push_back(lambda);
+        }
+        return lambdas;
+    }
+
+    inline float spectralDot(std::span<const float> a, std::span<const float> b)
+    {
+        assert(a.size() == b.size());
+        return Eigen::Map<const Eigen::VectorXf>(a.data(), a.size()).dot(Eigen::Map<const Eigen::VectorXf>(b.data(), b.size()));
+    }
+
     template <typename SpecA, typename SpecB>
     float RAYCE_API_EXPORT innerProduct(const SpecA& f, const SpecB& g)
     {
@@ -326,12 +434,13 @@ namespace rayce
         auto rangeB     = g.range();
         float minLambda = std::max(rangeA.x(), rangeB.x());
         float maxLambda = std::min(rangeA.y(), rangeB.y());
-        float integral  = 0.0;
-        for (float lambda = minLambda; lambda <= maxLambda; lambda += 1.0)
-        {
-            integral += f.evaluate(lambda) * g.evaluate(lambda);
-        }
-        return integral;
+
+        std::vector<float> lambdas = sampleLambdas(minLambda, maxLambda);
+        std::vector<float> valuesF(lambdas.size());
+        std::vector<float> valuesG(lambdas.size());
+        f.evaluate(lambdas, valuesF);
+        g.evaluate(lambdas, valuesG);
+        return spectralDot(valuesF, valuesG);
     }
 
     struct RAYCE_API_EXPORT Spectra
@@ -343,12 +452,58 @@ namespace rayce
         static constexpr float CIEYIntegral = 106.856895;
 
         static const LinearInterpolatedSpectrum* getNamedSpectrum(const str& name);
+
+        // a spd file spectrum and its rgb projection, see getFileSpectrum()
+        struct FileSpectrum
+        {
+            LinearInterpolatedSpectrum spectrum;
+            vec3 rgb;
+        };
+
+        // reads every spd file once per process, safe to call from several threads
+        // read is set to true if this call parsed the file, the returned spectrum stays valid until the process ends
+        static const FileSpectrum& getFileSpectrum(const str& filename, bool& read);
+
+        // parses all spd files of a directory in parallel into the getFileSpectrum() cache, returns the number of files read
+        static uint32 preloadFileSpectra(const str& directory);
     };
 
     template <typename Spec>
     vec3 RAYCE_API_EXPORT spectrumToXYZ(const Spec& spectrum)
     {
-        return vec3(innerProduct(spectrum, Spectra::CIEX), innerProduct(spectrum, Spectra::CIEY), innerProduct(spectrum, Spectra::CIEZ)) / Spectra::CIEYIntegral;
+        // the matching functions share one range, so the spectrum is only evaluated once for all three
+        auto range      = spectrum.range();
+        auto rangeCIE   = Spectra::CIEY.range();
+        float minLambda = std::max(range.x(), rangeCIE.x());
+        float maxLambda = std::min(range.y(), rangeCIE.y());
+
+        std::vector<float> lambdas = sampleLambdas(minLambda, maxLambda);
+        if (lambdas.empty())
+        {
+            return vec3(0.0, 0.0, 0.0);
+        }
+        std::vector<float> values(lambdas.size());
+        spectrum.evaluate(lambdas, values);
+
+        // on whole wavelengths the matching function samples are contiguous and used in place
+        if (minLambda == std::floor(minLambda))
+        {
+            ptr_size first = static_cast<ptr_size>(minLambda - rangeCIE.x());
+            return vec3(spectralDot(values, Spectra::CIEX.values().subspan(first, values.size())),
+                        spectralDot(values, Spectra::CIEY.values().subspan(first, values.size())),
+                        spectralDot(values, Spectra::CIEZ.values().subspan(first, values.size()))) /
+                   Spectra::CIEYIntegral;
+        }
+
+        std::vector<float> matching(lambdas.size());
+        vec3 xyz;
+        Spectra::CIEX.evaluate(lambdas, matching);
+        xyz.x() = spectralDot(values, matching);
+        Spectra::CIEY.evaluate(lambdas, matching);
+        xyz.y() = spectralDot(values, matching);
+        Spectra::CIEZ.evaluate(lambdas, matching);
+        xyz.z() = spectralDot(values, matching);
+        return xyz / Spectra::CIEYIntegral;
     }
 
     template <typename Spec>
@@ -39,6 +39,23 @@ namespace rayce
 
         return string.substr(start == str::npos ? 0 : start, end == str::npos ? string.length() - 1 : end - start + 1);
     }
+
+    /// @brief Calculates a 64 bit FNV-1a hash of some bytes.
+    /// @param[in] data The bytes to hash.
+    /// @param[in] size The number of bytes.
+    /// @param[in] seed The hash to continue from, defaults to the FNV offset basis.
+    /// @return The hash value.
+    inline uint64 hashBytes(const void* data, ptr_size size, uint64 seed = 14695981039346656037ull)
+    {
+        const byte* bytes = static_cast<const byte*>(data);
+        uint64 hash       = seed;
+        for (ptr_size i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
 } // namespace rayce
 
 #endif // UTILS_HPP
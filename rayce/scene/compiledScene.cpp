@@ -0,0 +1,463 @@
+/// @file      compiledScene.cpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#include <filesystem>
+#include <fstream>
+#include <scene/compiledScene.hpp>
+
+using namespace rayce;
+namespace fs = std::filesystem;
+
+static constexpr uint32 kCompiledSceneMagic   = 0x53454352; // "RCES"
+static constexpr uint32 kCompiledSceneVersion = 7;
+static constexpr ptr_size kBlobAlignment      = 16;
+
+struct CompiledSceneHeader
+{
+    uint32 magic;
+    uint32 version;
+    // reject files written by builds with a different struct layout
+    uint32 vertexSize;
+    uint32 materialSize;
+    uint32 lightSize;
+    uint32 materialCount;
+    uint32 lightCount;
+    uint32 textureCount;
+    uint32 meshCount;
+    uint32 sphereCount;
+    uint32 meshNameCount;
+    uint32 sourceFileCount;
+    uint64 optionsHash;
+};
+
+struct SourceFileRecord
+{
+    int64 time;
+    uint64 size;
+    uint32 pathLength;
+    uint32 pad;
+};
+
+struct TextureRecord
+{
+    uint32 width;
+    uint32 height;
+    uint32 components;
+    uint32 srgb;
+};
+
+struct MeshRecord
+{
+    uint64 vertexCount;
+    uint64 indexCount;
+    uint32 instanceCount;
+    uint32 triangleMaterialCount;
+    uint32 hasAttributes;
+    uint32 pad;
+};
+
+struct SphereRecord
+{
+    Sphere sphere;
+    AxisAlignedBoundingBox boundingBox;
+    uint32 materialId;
+    int32 lightId;
+    uint32 transformCount;
+};
+
+class CompiledSceneWriter
+{
+public:
+    CompiledSceneWriter(const str& filename)
+        : mFile(filename, std::ios::binary | std::ios::trunc)
+        , mOffset(0)
+    {
+    }
+
+    bool good() const
+    {
+        return mFile.good();
+    }
+
+    void write(const void* data, ptr_size size)
+    {
+        mFile.write(static_cast<const char*>(data), size);
+        mOffset += size;
+    }
+
+    template <typename T>
+    void write(const T& value)
+    {
+        write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void writeBlob(std::span<const T> data)
+    {
+        const char padding[kBlobAlignment] = {};
+        ptr_size paddingSize               = (kBlobAlignment - mOffset % kBlobAlignment) % kBlobAlignment;
+        write(padding, paddingSize);
+        write(data.data(), data.size_bytes());
+    }
+
+private:
+    std::ofstream mFile;
+    ptr_size mOffset;
+};
+
+class CompiledSceneReader
+{
+public:
+    CompiledSceneReader(const MappedFile& file)
+        : mData(file.getData())
+        , mSize(file.getSize())
+        , mOffset(0)
+    {
+    }
+
+    bool read(void* data, ptr_size size)
+    {
+        if (size > mSize - mOffset)
+        {
+            return false;
+        }
+        std::memcpy(data, mData + mOffset, size);
+        mOffset += size;
+        return true;
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        return read(&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool readBlob(std::span<const T>& data, ptr_size count)
+    {
+        mOffset = (mOffset + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+        // a corrupt count must not overflow the size check
+        if (mOffset > mSize || count > (mSize - mOffset) / sizeof(T))
+        {
+            return false;
+        }
+        data = std::span<const T>(reinterpret_cast<const T*>(mData + mOffset), count);
+        mOffset += count * sizeof(T);
+        return true;
+    }
+
+private:
+    const byte* mData;
+    ptr_size mSize;
+    ptr_size mOffset;
+};
+
+static bool querySourceFile(const str& filename, int64& time, uint64& size)
+{
+    std::error_code error;
+    time = static_cast<int64>(fs::last_write_time(filename, error).time_since_epoch().count());
+    if (error)
+    {
+        return false;
+    }
+    size = static_cast<uint64>(fs::file_size(filename, error));
+    return !error;
+}
+
+static bool writeCompiledSceneData(const str& filename, const CompiledScene& scene)
+{
+    CompiledSceneWriter writer(filename);
+    if (!writer.good())
+    {
+        return false;
+    }
+
+    CompiledSceneHeader header{};
+    header.magic         = kCompiledSceneMagic;
+    header.version       = kCompiledSceneVersion;
+    header.vertexSize    = sizeof(Vertex);
+    header.materialSize  = sizeof(Material);
+    header.lightSize     = sizeof(Light);
+    header.materialCount = static_cast<uint32>(scene.materials.size());
+    header.lightCount    = static_cast<uint32>(scene.lights.size());
+    header.textureCount  = static_cast<uint32>(scene.textures.size());
+    header.meshCount     = static_cast<uint32>(scene.meshes.size());
+    header.sphereCount   = static_cast<uint32>(scene.spheres.size());
+    header.meshNameCount   = static_cast<uint32>(scene.meshNames.size());
+    header.sourceFileCount = static_cast<uint32>(scene.sourceFiles.size());
+    header.optionsHash     = scene.optionsHash;
+    writer.write(header);
+
+    // a source that can not be queried is stored with zero size and time, so the file is recompiled next time
+    for (const str& source : scene.sourceFiles)
+    {
+        SourceFileRecord record{};
+        querySourceFile(source, record.time, record.size);
+        record.pathLength = static_cast<uint32>(source.size());
+        writer.write(record);
+        writer.write(source.data(), source.size());
+    }
+
+    writer.writeBlob(std::span<const Material>(scene.materials));
+    writer.writeBlob(std::span<const Light>(scene.lights));
+
+    for (const CompiledTexture& texture : scene.textures)
+    {
+        TextureRecord record{ texture.width, texture.height, texture.components, texture.srgb ? 1u : 0u };
+        writer.write(record);
+        writer.writeBlob(texture.pixels);
+    }
+
+    for (const CompiledMesh& mesh : scene.meshes)
+    {
+        MeshRecord record{ mesh.vertices.size(), mesh.indices.size(), static_cast<uint32>(mesh.transformationMatrices.size()), static_cast<uint32>(mesh.triangleMaterialIds.size()),
+                           mesh.hasAttributes ? 1u : 0u, 0 };
+        writer.write(record);
+        writer.writeBlob(std::span<const uint32>(mesh.materialIds));
+        writer.writeBlob(std::span<const int32>(mesh.lightIds));
+        writer.writeBlob(std::span<const mat4>(mesh.transformationMatrices));
+        writer.writeBlob(mesh.vertices);
+        writer.writeBlob(mesh.indices);
+        writer.writeBlob(mesh.triangleMaterialIds);
+    }
+
+    for (const CompiledSphere& sphere : scene.spheres)
+    {
+        SphereRecord record{ sphere.sphere, sphere.boundingBox, sphere.materialId, sphere.lightId, static_cast<uint32>(sphere.transformationMatrices.size()) };
+        writer.write(record);
+        writer.writeBlob(std::span<const mat4>(sphere.transformationMatrices));
+    }
+
+    for (ptr_size i = 0; i < scene.meshNames.size(); ++i)
+    {
+        uint32 length = static_cast<uint32>(scene.meshNames[i].size());
+        writer.write(length);
+        writer.write(i < scene.meshTriCounts.size() ? scene.meshTriCounts[i] : 0u);
+        writer.write(i < scene.meshSourceTriCounts.size() ? scene.meshSourceTriCounts[i] : 0u);
+        writer.write(i < scene.meshVertexCounts.size() ? scene.meshVertexCounts[i] : 0u);
+        writer.write(i < scene.meshSourceVertexCounts.size() ? scene.meshSourceVertexCounts[i] : 0u);
+        writer.write(scene.meshNames[i].data(), length);
+    }
+
+    return writer.good();
+}
+
+bool rayce::writeCompiledScene(const str& filename, const CompiledScene& scene)
+{
+    std::error_code error;
+    fs::path parent = fs::path(filename).parent_path();
+    if (!parent.empty())
+    {
+        fs::create_directories(parent, error);
+    }
+
+    // an interrupted write leaves the temporary file behind, never a truncated scene
+    str tmpPath = filename + ".tmp";
+    if (!writeCompiledSceneData(tmpPath, scene))
+    {
+        RAYCE_LOG_ERROR("Can not write compiled scene %s!", filename.c_str());
+        fs::remove(tmpPath, error);
+        return false;
+    }
+
+    fs::rename(tmpPath, filename, error);
+    if (error)
+    {
+        RAYCE_LOG_ERROR("Can not write compiled scene %s!", filename.c_str());
+        fs::remove(tmpPath, error);
+        return false;
+    }
+
+    RAYCE_LOG_INFO("Wrote compiled scene %s.", filename.c_str());
+
+    return true;
+}
+
+static bool validInstanceIds(std::span<const uint32> materialIds, std::span<const int32> lightIds, ptr_size materialCount, ptr_size lightCount)
+{
+    for (uint32 materialId : materialIds)
+    {
+        if (materialId >= materialCount)
+        {
+            return false;
+        }
+    }
+    for (int32 lightId : lightIds)
+    {
+        if (lightId < -1 || (lightId >= 0 && static_cast<ptr_size>(lightId) >= lightCount))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the compiled path skips the mesh cleanup, so everything the BLAS build and the shaders index with is checked here
+static bool validCompiledMesh(const CompiledMesh& mesh, ptr_size materialCount, ptr_size lightCount)
+{
+    if (mesh.vertices.empty() || mesh.indices.size() % 3 != 0)
+    {
+        return false;
+    }
+    for (uint32 index : mesh.indices)
+    {
+        if (index >= mesh.vertices.size())
+        {
+            return false;
+        }
+    }
+    if (!mesh.triangleMaterialIds.empty() && mesh.triangleMaterialIds.size() != mesh.indices.size() / 3)
+    {
+        return false;
+    }
+    return validInstanceIds(mesh.materialIds, mesh.lightIds, materialCount, lightCount) && validInstanceIds(mesh.triangleMaterialIds, {}, materialCount, lightCount);
+}
+
+bool rayce::readCompiledScene(const str& filename, uint64 optionsHash, CompiledScene& scene)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+    if (!file->valid())
+    {
+        RAYCE_LOG_ERROR("Can not open compiled scene %s!", filename.c_str());
+        return false;
+    }
+
+    CompiledSceneReader reader(*file);
+
+    CompiledSceneHeader header;
+    if (!reader.read(header) || header.magic != kCompiledSceneMagic || header.version != kCompiledSceneVersion)
+    {
+        RAYCE_LOG_ERROR("%s is not a compiled scene of this version!", filename.c_str());
+        return false;
+    }
+    if (header.vertexSize != sizeof(Vertex) || header.materialSize != sizeof(Material) || header.lightSize != sizeof(Light))
+    {
+        RAYCE_LOG_ERROR("%s was compiled with a different data layout!", filename.c_str());
+        return false;
+    }
+
+    if (header.optionsHash != optionsHash)
+    {
+        RAYCE_LOG_INFO("%s was compiled with different load options.", filename.c_str());
+        return false;
+    }
+
+    auto corrupted = [&filename]()
+    {
+        RAYCE_LOG_ERROR("Compiled scene %s is corrupted!", filename.c_str());
+        return false;
+    };
+
+    scene.sourceFiles.resize(header.sourceFileCount);
+    for (str& source : scene.sourceFiles)
+    {
+        SourceFileRecord record;
+        if (!reader.read(record))
+        {
+            return corrupted();
+        }
+        source.resize(record.pathLength);
+        if (!reader.read(source.data(), record.pathLength))
+        {
+            return corrupted();
+        }
+
+        int64 time;
+        uint64 size;
+        if (!querySourceFile(source, time, size) || time != record.time || size != record.size)
+        {
+            RAYCE_LOG_INFO("%s is out of date, %s changed.", filename.c_str(), source.c_str());
+            return false;
+        }
+    }
+    scene.optionsHash = header.optionsHash;
+
+    std::span<const Material> materials;
+    std::span<const Light> lights;
+    if (!reader.readBlob(materials, header.materialCount) || !reader.readBlob(lights, header.lightCount))
+    {
+        return corrupted();
+    }
+    scene.materials.assign(materials.begin(), materials.end());
+    scene.lights.assign(lights.begin(), lights.end());
+
+    scene.textures.resize(header.textureCount);
+    for (CompiledTexture& texture : scene.textures)
+    {
+        TextureRecord record;
+        if (!reader.read(record) || record.components > 4 || !reader.readBlob(texture.pixels, static_cast<ptr_size>(record.width) * record.height * record.components))
+        {
+            return corrupted();
+        }
+        texture.width      = record.width;
+        texture.height     = record.height;
+        texture.components = record.components;
+        texture.srgb       = record.srgb != 0;
+    }
+
+    scene.meshes.resize(header.meshCount);
+    for (CompiledMesh& mesh : scene.meshes)
+    {
+        MeshRecord record;
+        std::span<const uint32> materialIds;
+        std::span<const int32> lightIds;
+        std::span<const mat4> transformationMatrices;
+        if (!reader.read(record) || !reader.readBlob(materialIds, record.instanceCount) || !reader.readBlob(lightIds, record.instanceCount) ||
+            !reader.readBlob(transformationMatrices, record.instanceCount) || !reader.readBlob(mesh.vertices, record.vertexCount) || !reader.readBlob(mesh.indices, record.indexCount) ||
+            !reader.readBlob(mesh.triangleMaterialIds, record.triangleMaterialCount))
+        {
+            return corrupted();
+        }
+        mesh.hasAttributes = record.hasAttributes != 0;
+        mesh.materialIds.assign(materialIds.begin(), materialIds.end());
+        mesh.lightIds.assign(lightIds.begin(), lightIds.end());
+        mesh.transformationMatrices.assign(transformationMatrices.begin(), transformationMatrices.end());
+        if (!validCompiledMesh(mesh, scene.materials.size(), scene.lights.size()))
+        {
+            return corrupted();
+        }
+    }
+
+    scene.spheres.resize(header.sphereCount);
+    for (CompiledSphere& sphere : scene.spheres)
+    {
+        SphereRecord record;
+        std::span<const mat4> transformationMatrices;
+        if (!reader.read(record) || !reader.readBlob(transformationMatrices, record.transformCount) ||
+            !validInstanceIds({ &record.materialId, 1 }, { &record.lightId, 1 }, scene.materials.size(), scene.lights.size()))
+        {
+            return corrupted();
+        }
+        sphere.sphere      = record.sphere;
+        sphere.boundingBox = record.boundingBox;
+        sphere.materialId  = record.materialId;
+        sphere.lightId     = record.lightId;
+        sphere.transformationMatrices.assign(transformationMatrices.begin(), transformationMatrices.end());
+    }
+
+    scene.meshNames.resize(header.meshNameCount);
+    scene.meshTriCounts.resize(header.meshNameCount);
+    scene.meshSourceTriCounts.resize(header.meshNameCount);
+    scene.meshVertexCounts.resize(header.meshNameCount);
+    scene.meshSourceVertexCounts.resize(header.meshNameCount);
+    for (ptr_size i = 0; i < header.meshNameCount; ++i)
+    {
+        uint32 length;
+        if (!reader.read(length) || !reader.read(scene.meshTriCounts[i]) || !reader.read(scene.meshSourceTriCounts[i]) || !reader.read(scene.meshVertexCounts[i]) || !reader.read(scene.meshSourceVertexCounts[i]))
+        {
+            return corrupted();
+        }
+        scene.meshNames[i].resize(length);
+        if (!reader.read(scene.meshNames[i].data(), length))
+        {
+            return corrupted();
+        }
+    }
+
+    scene.mappedFile = std::move(file);
+
+    return true;
+}
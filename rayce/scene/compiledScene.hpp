@@ -0,0 +1,118 @@
+/// @file      compiledScene.hpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#pragma once
+
+#ifndef COMPILED_SCENE_HPP
+#define COMPILED_SCENE_HPP
+
+#include <core/mappedFile.hpp>
+#include <hostDeviceInterop.slang>
+#include <span>
+
+namespace rayce
+{
+    /// @brief A pre-decoded texture of a @a CompiledScene.
+    struct CompiledTexture
+    {
+        /// @brief The width in pixels.
+        uint32 width;
+        /// @brief The height in pixels.
+        uint32 height;
+        /// @brief The number of 8 bit components per pixel.
+        uint32 components;
+        /// @brief True if the texture holds sRGB data, else False.
+        bool srgb;
+        /// @brief The pixel data.
+        std::span<const byte> pixels;
+    };
+
+    /// @brief A resolved triangle mesh of a @a CompiledScene.
+    struct CompiledMesh
+    {
+        /// @brief The vertices of the mesh.
+        std::span<const Vertex> vertices;
+        /// @brief The indices of the mesh.
+        std::span<const uint32> indices;
+        /// @brief The material index per instance.
+        std::vector<uint32> materialIds;
+        /// @brief The light index per instance, -1 if the instance is not emissive.
+        std::vector<int32> lightIds;
+        /// @brief The instance transformations.
+        std::vector<mat4> transformationMatrices;
+        /// @brief The material index per triangle of merged meshes, empty if the instance materials are used.
+        std::span<const uint32> triangleMaterialIds;
+        /// @brief True if the mesh has normals or uvs and needs an attribute stream, else False.
+        bool hasAttributes{ true };
+    };
+
+    /// @brief A resolved sphere of a @a CompiledScene.
+    struct CompiledSphere
+    {
+        /// @brief The world space sphere.
+        Sphere sphere;
+        /// @brief The bounds of the sphere.
+        AxisAlignedBoundingBox boundingBox;
+        /// @brief The material index.
+        uint32 materialId;
+        /// @brief The light index, -1 if the sphere is not emissive.
+        int32 lightId;
+        /// @brief The instance transformations.
+        std::vector<mat4> transformationMatrices;
+    };
+
+    /// @brief Everything needed to recreate a loaded scene without parsing the source files.
+    /// @details Spans either point into @a mappedFile after reading or into data owned by the writer.
+    struct CompiledScene
+    {
+        /// @brief The resolved materials.
+        std::vector<Material> materials;
+        /// @brief The resolved lights.
+        std::vector<Light> lights;
+        /// @brief The decoded textures in texture index order.
+        std::vector<CompiledTexture> textures;
+        /// @brief The triangle meshes.
+        std::vector<CompiledMesh> meshes;
+        /// @brief The spheres.
+        std::vector<CompiledSphere> spheres;
+        /// @brief The names of all shapes for the reflection info.
+        std::vector<str> meshNames;
+        /// @brief The triangle counts of all shapes for the reflection info.
+        std::vector<uint32> meshTriCounts;
+        /// @brief The triangle counts before the cleanup of all shapes for the reflection info.
+        std::vector<uint32> meshSourceTriCounts;
+        /// @brief The vertex counts of all shapes for the reflection info.
+        std::vector<uint32> meshVertexCounts;
+        /// @brief The vertex counts before welding of all shapes for the reflection info.
+        std::vector<uint32> meshSourceVertexCounts;
+        /// @brief The scene, mesh and texture files the scene was compiled from.
+        std::vector<str> sourceFiles;
+        /// @brief The hash of the load options the scene was compiled with.
+        uint64 optionsHash{ 0 };
+
+        /// @brief The mapped compiled scene file the spans point into after reading.
+        std::shared_ptr<MappedFile> mappedFile;
+    };
+
+    /// @brief Writes a @a CompiledScene to a file.
+    /// @details The data is written to a temporary file that replaces @p filename once it is complete. Size and modification time of
+    /// all @a CompiledScene::sourceFiles are stored to detect outdated files.
+    /// @param[in] filename The file to write.
+    /// @param[in] scene The @a CompiledScene to write.
+    /// @return True on success, else False.
+    bool writeCompiledScene(const str& filename, const CompiledScene& scene);
+
+    /// @brief Reads a @a CompiledScene from a file.
+    /// @details The file is memory mapped, mesh and texture data is not copied. Files compiled with other options or from source
+    /// files that changed since are rejected, as are meshes with out of range indices, material or light ids.
+    /// @param[in] filename The file to read.
+    /// @param[in] optionsHash The hash of the load options the scene has to be compiled with.
+    /// @param[out] scene The @a CompiledScene to fill.
+    /// @return True on success, else False.
+    bool readCompiledScene(const str& filename, uint64 optionsHash, CompiledScene& scene);
+} // namespace rayce
+
+#endif // COMPILED_SCENE_HPP
@@ -0,0 +1,258 @@
+/// @file      meshCache.cpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#include <core/utils.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <scene/meshCache.hpp>
+#include <sstream>
+#include <thread>
+
+using namespace rayce;
+namespace fs = std::filesystem;
+
+static constexpr uint32 kMeshCacheMagic   = 0x4853454d; // "MESH"
+static constexpr uint32 kMeshCacheVersion = 5;
+static constexpr ptr_size kDataAlignment  = 16;
+
+// sources up to this size are hashed when stored, larger ones are only validated by size and modification time,
+// so a cache miss on a huge file does not pay for an extra pass over it
+static constexpr uint64 kMaxHashedSourceSize = 64ull * 1024 * 1024;
+static constexpr uint64 kNoContentHash       = 0;
+
+struct MeshCacheHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint32 variant;
+    uint32 hasUVs;
+    int64 sourceTime;
+    uint64 sourceSize;
+    uint64 contentHash;
+    uint64 vertexCount;
+    uint64 indexCount;
+    uint64 sourceVertexCount;
+    float boundsMinimum[3];
+    float boundsMaximum[3];
+    uint32 pathLength;
+    float cacheMissesBefore;
+    float cacheMissesAfter;
+    uint32 sourceTriangleCount;
+    uint32 hasNormals;
+};
+
+struct SourceInfo
+{
+    str canonicalPath;
+    int64 time;
+    uint64 size;
+};
+
+static bool querySource(const str& filename, SourceInfo& info)
+{
+    std::error_code error;
+    info.canonicalPath = fs::weakly_canonical(filename, error).generic_string();
+    if (error)
+    {
+        return false;
+    }
+    info.time = static_cast<int64>(fs::last_write_time(filename, error).time_since_epoch().count());
+    if (error)
+    {
+        return false;
+    }
+    info.size = static_cast<uint64>(fs::file_size(filename, error));
+    return !error;
+}
+
+static uint64 hashFileContent(const str& filename)
+{
+    MappedFile source(filename);
+    if (!source.valid())
+    {
+        return 0;
+    }
+    return hashBytes(source.getData(), source.getSize());
+}
+
+static str cacheEntryPath(const str& cacheDirectory, const str& canonicalPath, uint32 variant)
+{
+    std::stringstream name;
+    name << std::hex << hashBytes(canonicalPath.data(), canonicalPath.size()) << "_" << variant << ".meshcache";
+    return (fs::path(cacheDirectory) / name.str()).string();
+}
+
+static ptr_size dataOffset(uint32 pathLength)
+{
+    return (sizeof(MeshCacheHeader) + pathLength + kDataAlignment - 1) & ~(kDataAlignment - 1);
+}
+
+str rayce::defaultMeshCacheDirectory()
+{
+    std::error_code error;
+#ifdef _WIN32
+    if (const char* localAppData = std::getenv("LOCALAPPDATA"); localAppData && *localAppData)
+    {
+        return (fs::path(localAppData) / "rayce" / "meshes").string();
+    }
+#else
+    if (const char* cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+    {
+        return (fs::path(cacheHome) / "rayce" / "meshes").string();
+    }
+    if (const char* home = std::getenv("HOME"); home && *home)
+    {
+        return (fs::path(home) / ".cache" / "rayce" / "meshes").string();
+    }
+#endif
+    return (fs::temp_directory_path(error) / "rayce" / "meshes").string();
+}
+
+bool rayce::loadCachedMesh(const str& cacheDirectory, const str& filename, uint32 variant, MeshData& mesh)
+{
+    SourceInfo source;
+    if (!querySource(filename, source))
+    {
+        return false;
+    }
+
+    str entryPath = cacheEntryPath(cacheDirectory, source.canonicalPath, variant);
+    if (!fs::exists(entryPath))
+    {
+        return false;
+    }
+
+    std::shared_ptr<MappedFile> entry = std::make_shared<MappedFile>(entryPath);
+    if (!entry->valid() || entry->getSize() < sizeof(MeshCacheHeader))
+    {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy(&header, entry->getData(), sizeof(MeshCacheHeader));
+
+    if (header.magic != kMeshCacheMagic || header.version != kMeshCacheVersion || header.variant != variant || header.sourceSize != source.size)
+    {
+        return false;
+    }
+
+    ptr_size offset       = dataOffset(header.pathLength);
+    ptr_size expectedSize = offset + header.vertexCount * sizeof(Vertex) + header.indexCount * sizeof(uint32);
+    if (entry->getSize() != expectedSize)
+    {
+        RAYCE_LOG_WARN("Mesh cache entry %s is corrupted!", entryPath.c_str());
+        return false;
+    }
+
+    str storedPath(reinterpret_cast<const char*>(entry->getData() + sizeof(MeshCacheHeader)), header.pathLength);
+    if (storedPath != source.canonicalPath)
+    {
+        return false;
+    }
+
+    // a touched but unchanged file is still valid, the content is only hashed if the time differs and the entry stored a hash
+    if (header.sourceTime != source.time && (header.contentHash == kNoContentHash || header.contentHash != hashFileContent(filename)))
+    {
+        return false;
+    }
+
+    const byte* data    = entry->getData() + offset;
+    mesh.mappedVertices      = std::span<const Vertex>(reinterpret_cast<const Vertex*>(data), header.vertexCount);
+    mesh.mappedIndices       = std::span<const uint32>(reinterpret_cast<const uint32*>(data + header.vertexCount * sizeof(Vertex)), header.indexCount);
+    mesh.mappedFile          = std::move(entry);
+    mesh.hasUVs              = header.hasUVs != 0;
+    mesh.hasNormals          = header.hasNormals != 0;
+    mesh.sourceVertexCount   = static_cast<uint32>(header.sourceVertexCount);
+    mesh.sourceTriangleCount = header.sourceTriangleCount;
+    mesh.bounds.minimum      = vec3(header.boundsMinimum[0], header.boundsMinimum[1], header.boundsMinimum[2]);
+    mesh.bounds.maximum      = vec3(header.boundsMaximum[0], header.boundsMaximum[1], header.boundsMaximum[2]);
+    mesh.cacheMissesBefore   = header.cacheMissesBefore;
+    mesh.cacheMissesAfter    = header.cacheMissesAfter;
+
+    RAYCE_LOG_INFO("Loaded %s from mesh cache.", filename.c_str());
+
+    return true;
+}
+
+bool rayce::storeCachedMesh(const str& cacheDirectory, const str& filename, uint32 variant, const MeshData& mesh)
+{
+    SourceInfo source;
+    if (!querySource(filename, source))
+    {
+        return false;
+    }
+
+    std::error_code error;
+    fs::create_directories(cacheDirectory, error);
+    if (error)
+    {
+        RAYCE_LOG_WARN("Can not create mesh cache directory %s!", cacheDirectory.c_str());
+        return false;
+    }
+
+    std::span<const Vertex> vertices = mesh.getVertices();
+    std::span<const uint32> indices  = mesh.getIndices();
+
+    MeshCacheHeader header{};
+    header.magic             = kMeshCacheMagic;
+    header.version           = kMeshCacheVersion;
+    header.variant           = variant;
+    header.hasUVs            = mesh.hasUVs ? 1 : 0;
+    header.sourceTime        = source.time;
+    header.sourceSize        = source.size;
+    header.contentHash       = source.size <= kMaxHashedSourceSize ? hashFileContent(filename) : kNoContentHash;
+    header.vertexCount       = vertices.size();
+    header.indexCount        = indices.size();
+    header.sourceVertexCount = mesh.sourceVertexCount;
+    for (int32 i = 0; i < 3; ++i)
+    {
+        header.boundsMinimum[i] = mesh.bounds.minimum[i];
+        header.boundsMaximum[i] = mesh.bounds.maximum[i];
+    }
+    header.pathLength          = static_cast<uint32>(source.canonicalPath.size());
+    header.cacheMissesBefore   = mesh.cacheMissesBefore;
+    header.cacheMissesAfter    = mesh.cacheMissesAfter;
+    header.sourceTriangleCount = mesh.sourceTriangleCount;
+    header.hasNormals          = mesh.hasNormals ? 1 : 0;
+
+    str entryPath = cacheEntryPath(cacheDirectory, source.canonicalPath, variant);
+    // several workers can store the same entry, every one writes its own file and the last rename wins
+    str tmpPath = entryPath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            RAYCE_LOG_WARN("Can not write mesh cache entry %s!", tmpPath.c_str());
+            return false;
+        }
+
+        const char padding[kDataAlignment] = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+        file.write(source.canonicalPath.data(), source.canonicalPath.size());
+        file.write(padding, dataOffset(header.pathLength) - sizeof(MeshCacheHeader) - header.pathLength);
+        file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size_bytes());
+        file.write(reinterpret_cast<const char*>(indices.data()), indices.size_bytes());
+
+        if (!file.good())
+        {
+            RAYCE_LOG_WARN("Can not write mesh cache entry %s!", tmpPath.c_str());
+            file.close();
+            fs::remove(tmpPath, error);
+            return false;
+        }
+    }
+
+    fs::rename(tmpPath, entryPath, error);
+    if (error)
+    {
+        fs::remove(tmpPath, error);
+        return false;
+    }
+
+    return true;
+}
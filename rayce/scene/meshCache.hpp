@@ -0,0 +1,45 @@
+/// @file      meshCache.hpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#pragma once
+
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <scene/meshLoader.hpp>
+
+namespace rayce
+{
+    /// @brief Retrieves the per user directory for the binary mesh cache.
+    /// @details LOCALAPPDATA/rayce/meshes on Windows, XDG_CACHE_HOME/rayce/meshes or ~/.cache/rayce/meshes elsewhere.
+    /// Falls back to the temporary directory if none of them is set.
+    /// @return The mesh cache directory.
+    str defaultMeshCacheDirectory();
+
+    /// @brief Loads a mesh from the binary on-disk cache.
+    /// @details Thread safe, can be called from worker threads.
+    /// The cache entry is memory mapped and referenced by the @a MeshData, no vertex or index data is copied.
+    /// An entry is valid if it was written for the same source path and variant and either the modification time
+    /// or the content hash of the source file still match. Entries of sources larger than 64 MiB store no content hash
+    /// and are invalidated by any change of the modification time.
+    /// @param[in] cacheDirectory The directory holding the cache entries.
+    /// @param[in] filename The source mesh file.
+    /// @param[in] variant Bit mask of the loader settings that change the resulting data.
+    /// @param[out] mesh The @a MeshData to fill.
+    /// @return True on a cache hit, else False.
+    bool loadCachedMesh(const str& cacheDirectory, const str& filename, uint32 variant, MeshData& mesh);
+
+    /// @brief Writes a loaded mesh to the binary on-disk cache.
+    /// @details Thread safe, can be called from worker threads.
+    /// @param[in] cacheDirectory The directory holding the cache entries, created if it does not exist.
+    /// @param[in] filename The source mesh file.
+    /// @param[in] variant Bit mask of the loader settings that change the resulting data.
+    /// @param[in] mesh The loaded @a MeshData.
+    /// @return True on success, else False.
+    bool storeCachedMesh(const str& cacheDirectory, const str& filename, uint32 variant, const MeshData& mesh);
+} // namespace rayce
+
+#endif // MESH_CACHE_HPP
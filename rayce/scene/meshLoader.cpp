@@ -0,0 +1,1352 @@
+/// @file      meshLoader.cpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#include <charconv>
+#include <core/parallel.hpp>
+#include <core/timer.hpp>
+#include <core/utils.hpp>
+#include <filesystem>
+#include <numeric>
+#include <scene/meshLoader.hpp>
+
+#include <scene/miniply.h>
+#include <scene/stb_image.h>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+using namespace rayce;
+
+// obj files from this size on are parsed by the parallel parser instead of tinyobj
+static constexpr ptr_size kParallelObjFileSize = 16 * 1024 * 1024;
+static constexpr ptr_size kObjChunkSize        = 1024 * 1024;
+
+// vertices are preprocessed in lanes of 8 and in blocks on the worker pool
+static constexpr ptr_size kVertexLanes     = 8;
+static constexpr ptr_size kVertexBlockSize = 64 * 1024;
+using VertexLanes = Eigen::Array<float, kVertexLanes, 1>;
+
+static void assembleVertices(const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec2>& uvs, MeshData& mesh)
+{
+    const bool hasNormals  = normals.size() == positions.size();
+    mesh.hasUVs            = uvs.size() == positions.size();
+    mesh.hasNormals        = hasNormals;
+    mesh.sourceVertexCount = static_cast<uint32>(positions.size());
+    mesh.vertices.resize(positions.size());
+
+    const ptr_size blockCount = (positions.size() + kVertexBlockSize - 1) / kVertexBlockSize;
+    std::vector<AxisAlignedBoundingBox> blockBounds(blockCount);
+
+    parallelFor(blockCount,
+                [&](ptr_size b)
+                {
+                    const ptr_size blockBegin = b * kVertexBlockSize;
+                    const ptr_size blockEnd   = std::min(blockBegin + kVertexBlockSize, positions.size());
+
+                    VertexLanes minimum[3], maximum[3];
+                    for (int32 c = 0; c < 3; ++c)
+                    {
+                        minimum[c].setConstant(std::numeric_limits<float>::max());
+                        maximum[c].setConstant(std::numeric_limits<float>::lowest());
+                    }
+
+                    for (ptr_size first = blockBegin; first < blockEnd; first += kVertexLanes)
+                    {
+                        // the last lanes of a partial batch repeat the first vertex, that does not change the bounds
+                        const ptr_size laneCount = std::min(kVertexLanes, blockEnd - first);
+                        VertexLanes position[3], normal[3];
+                        for (ptr_size l = 0; l < kVertexLanes; ++l)
+                        {
+                            const ptr_size v = first + (l < laneCount ? l : 0);
+                            for (int32 c = 0; c < 3; ++c)
+                            {
+                                position[c][l] = positions[v][c];
+                                normal[c][l]   = hasNormals ? normals[v][c] : 0.0f;
+                            }
+                        }
+
+                        for (int32 c = 0; c < 3; ++c)
+                        {
+                            minimum[c] = minimum[c].min(position[c]);
+                            maximum[c] = maximum[c].max(position[c]);
+                        }
+
+                        // same summation order and result as vec3::normalized(), zero length normals stay zero
+                        VertexLanes squaredLength = normal[0] * normal[0] + (normal[1] * normal[1] + normal[2] * normal[2]);
+                        VertexLanes length        = (squaredLength > 0.0f).select(squaredLength.sqrt(), 1.0f);
+                        for (int32 c = 0; c < 3; ++c)
+                        {
+                            normal[c] /= length;
+                        }
+
+                        for (ptr_size l = 0; l < laneCount; ++l)
+                        {
+                            Vertex& vertex  = mesh.vertices[first + l];
+                            vertex.position = positions[first + l];
+                            vertex.normal   = vec3(normal[0][l], normal[1][l], normal[2][l]);
+                            vertex.uv       = mesh.hasUVs ? uvs[first + l] : vec2(1.0, 1.0);
+                        }
+                    }
+
+                    AxisAlignedBoundingBox& bounds = blockBounds[b];
+                    bounds.minimum                 = vec3(minimum[0].minCoeff(), minimum[1].minCoeff(), minimum[2].minCoeff());
+                    bounds.maximum                 = vec3(maximum[0].maxCoeff(), maximum[1].maxCoeff(), maximum[2].maxCoeff());
+                });
+
+    mesh.bounds.minimum = vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    mesh.bounds.maximum = vec3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    for (const AxisAlignedBoundingBox& bounds : blockBounds)
+    {
+        mesh.bounds.minimum = mesh.bounds.minimum.cwiseMin(bounds.minimum);
+        mesh.bounds.maximum = mesh.bounds.maximum.cwiseMax(bounds.maximum);
+    }
+}
+
+AxisAlignedBoundingBox rayce::transformBounds(const AxisAlignedBoundingBox& bounds, const mat4& transformation)
+{
+    AxisAlignedBoundingBox result;
+    result.minimum = vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    result.maximum = vec3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    for (int32 corner = 0; corner < 8; ++corner)
+    {
+        vec3 position(corner & 1 ? bounds.maximum.x() : bounds.minimum.x(), corner & 2 ? bounds.maximum.y() : bounds.minimum.y(), corner & 4 ? bounds.maximum.z() : bounds.minimum.z());
+        vec3 transformed = (transformation * position.homogeneous()).head<3>();
+        result.minimum   = result.minimum.cwiseMin(transformed);
+        result.maximum   = result.maximum.cwiseMax(transformed);
+    }
+    return result;
+}
+
+bool rayce::loadPlyMesh(const str& filename, MeshData& mesh)
+{
+    RAYCE_LOG_INFO("Loading: %s.", filename.c_str());
+    miniply::PLYReader plyReader(filename.c_str());
+
+    if (!plyReader.valid())
+    {
+        RAYCE_LOG_ERROR("Can not load: %s!", filename.c_str());
+        return false;
+    }
+
+    bool hasPositions = false, hasIndices = false, hasNormals = false, hasUVs = false;
+    uint32 positionIndices[3];
+    uint32 normalIndices[3];
+    uint32 uvIndices[2];
+    uint32 indexIndex;
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec2> uvs;
+
+    while (plyReader.has_element() && (!hasPositions || !hasIndices || !hasNormals || !hasUVs))
+    {
+        if (plyReader.element_is(miniply::kPLYVertexElement))
+        {
+            if (!plyReader.load_element())
+            {
+                RAYCE_LOG_ERROR("Can not load index element. Canceling the loading process!");
+                break;
+            }
+
+            if (!plyReader.find_pos(positionIndices))
+            {
+                RAYCE_LOG_ERROR("Can not find position properties. Canceling the loading process!");
+                break;
+            }
+
+            hasPositions = true;
+            positions.resize(plyReader.num_rows());
+            plyReader.extract_properties(positionIndices, 3, miniply::PLYPropertyType::Float, positions.data());
+
+            if (plyReader.find_normal(normalIndices))
+            {
+                hasNormals = true;
+                normals.resize(plyReader.num_rows());
+                plyReader.extract_properties(normalIndices, 3, miniply::PLYPropertyType::Float, normals.data());
+            }
+
+            if (plyReader.find_texcoord(uvIndices))
+            {
+                hasUVs = true;
+                uvs.resize(plyReader.num_rows());
+                plyReader.extract_properties(uvIndices, 2, miniply::PLYPropertyType::Float, uvs.data());
+            }
+        }
+        else if (!hasIndices && plyReader.element_is(miniply::kPLYFaceElement))
+        {
+            if (!plyReader.load_element())
+            {
+                RAYCE_LOG_ERROR("Can not load face element. Canceling the loading process!");
+                break;
+            }
+
+            if (!plyReader.find_indices(&indexIndex))
+            {
+                RAYCE_LOG_ERROR("Can not find index properties. Canceling the loading process!");
+                break;
+            }
+
+            hasIndices = true;
+
+            bool hasPolygons = plyReader.requires_triangulation(indexIndex);
+
+            if (hasPolygons)
+            {
+                if (!hasPositions)
+                {
+                    RAYCE_LOG_ERROR("Can not triangulate before finding vertex data. Canceling the loading process!");
+                    break;
+                }
+                mesh.indices.resize(plyReader.num_triangles(indexIndex) * 3);
+                plyReader.extract_triangles(indexIndex, reinterpret_cast<float*>(positions.data()), positions.size(), miniply::PLYPropertyType::Int, mesh.indices.data());
+            }
+            else
+            {
+                mesh.indices.resize(plyReader.num_rows() * 3);
+                plyReader.extract_list_property(indexIndex, miniply::PLYPropertyType::Int, mesh.indices.data());
+            }
+        }
+
+        plyReader.next_element();
+    }
+
+    if (!(hasPositions && hasIndices))
+    {
+        RAYCE_LOG_ERROR("%s has no positions or indices!", filename.c_str());
+        return false;
+    }
+
+    assembleVertices(positions, normals, uvs, mesh);
+
+    return true;
+}
+
+bool rayce::loadObjMesh(const str& filename, MeshData& mesh)
+{
+    std::error_code error;
+    if (std::filesystem::file_size(filename, error) >= kParallelObjFileSize && !error)
+    {
+        return loadObjMeshParallel(filename, mesh);
+    }
+
+    RAYCE_LOG_INFO("Loading: %s.", filename.c_str());
+    tinyobj::ObjReader objReader;
+    tinyobj::ObjReaderConfig config;
+    config.triangulate = true;
+    bool success       = objReader.ParseFromFile(filename.c_str(), config);
+
+    if (!success)
+    {
+        RAYCE_LOG_ERROR("Can not load: %s!", filename.c_str());
+        return false;
+    }
+
+    if (!objReader.Warning().empty())
+    {
+        RAYCE_LOG_WARN("TinyObjReader: %s", objReader.Warning().c_str());
+    }
+
+    auto& attrib = objReader.GetAttrib();
+    auto& shapes = objReader.GetShapes();
+
+    bool hasPositions = !attrib.vertices.empty(), hasIndices = hasPositions;
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec2> uvs;
+    uint32 vertIdx = 0;
+
+    // one vertex per face corner, welding merges the identical ones afterwards
+    for (size_t s = 0; s < shapes.size(); ++s)
+    {
+        size_t indexOffset = 0;
+        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); ++f)
+        {
+            size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
+
+            for (size_t v = 0; v < fv; v++)
+            {
+                tinyobj::index_t idx = shapes[s].mesh.indices[indexOffset + v];
+
+                mesh.indices.push_back(vertIdx);
+
+                tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0];
+                tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
+                tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
+
+                positions.push_back(vec3(vx, vy, vz));
+
+                if (idx.normal_index >= 0)
+                {
+                    tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
+                    tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
+                    tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
+
+                    normals.push_back(vec3(nx, ny, nz));
+                }
+
+                if (idx.texcoord_index >= 0)
+                {
+                    tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
+                    tinyobj::real_t ty = attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
+
+                    uvs.push_back(vec2(tx, ty));
+                }
+                vertIdx++;
+            }
+            indexOffset += fv;
+        }
+    }
+
+    if (!(hasPositions && hasIndices))
+    {
+        RAYCE_LOG_ERROR("%s has no positions or indices!", filename.c_str());
+        return false;
+    }
+
+    assembleVertices(positions, normals, uvs, mesh);
+    weldVertices(mesh);
+
+    return true;
+}
+
+namespace
+{
+    /// @brief One face corner of an obj file, indices are zero based, -1 if not present.
+    struct ObjCorner
+    {
+        int64 position;
+        int64 uv;
+        int64 normal;
+    };
+
+    /// @brief The records parsed from one line aligned chunk of an obj file.
+    struct ObjChunk
+    {
+        std::vector<vec3> positions;
+        std::vector<vec3> normals;
+        std::vector<vec2> uvs;
+        std::vector<ObjCorner> corners;
+        // negative obj indices are relative to the records parsed so far and can only be resolved after merging
+        std::vector<byte> cornerRelative;
+        // first corner of every triangulated quad, the split diagonal is chosen after merging
+        std::vector<ptr_size> quads;
+        bool valid{ true };
+    };
+} // namespace
+
+static const char* skipSpaces(const char* begin, const char* end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+static const char* parseFloat(const char* begin, const char* end, float& value)
+{
+    begin = skipSpaces(begin, end);
+    if (begin < end && *begin == '+')
+    {
+        ++begin;
+    }
+    std::from_chars_result result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+static const char* parseIndex(const char* begin, const char* end, int64& value)
+{
+    std::from_chars_result result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+static bool parseObjLine(const char* begin, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& face, std::vector<byte>& faceRelative)
+{
+    begin = skipSpaces(begin, end);
+    if (begin == end || *begin == '#')
+    {
+        return true;
+    }
+
+    auto keyword = [&](const char* name, ptr_size length)
+    {
+        return static_cast<ptr_size>(end - begin) > length && std::memcmp(begin, name, length) == 0 && (begin[length] == ' ' || begin[length] == '\t');
+    };
+
+    if (keyword("v", 1) || keyword("vn", 2))
+    {
+        bool normal = begin[1] == 'n';
+        const char* cursor = begin + (normal ? 2 : 1);
+        vec3 value;
+        for (int32 i = 0; i < 3; ++i)
+        {
+            cursor = parseFloat(cursor, end, value[i]);
+            if (!cursor)
+            {
+                return false;
+            }
+        }
+        (normal ? chunk.normals : chunk.positions).push_back(value);
+        return true;
+    }
+
+    if (keyword("vt", 2))
+    {
+        const char* cursor = begin + 2;
+        vec2 value;
+        for (int32 i = 0; i < 2; ++i)
+        {
+            cursor = parseFloat(cursor, end, value[i]);
+            if (!cursor)
+            {
+                return false;
+            }
+        }
+        chunk.uvs.push_back(value);
+        return true;
+    }
+
+    if (keyword("f", 1))
+    {
+        face.clear();
+        faceRelative.clear();
+        const char* cursor = skipSpaces(begin + 1, end);
+        while (cursor < end)
+        {
+            // v, v/vt, v//vn or v/vt/vn
+            int64 indices[3]       = { 0, 0, 0 };
+            int64 counts[3]        = { static_cast<int64>(chunk.positions.size()), static_cast<int64>(chunk.uvs.size()), static_cast<int64>(chunk.normals.size()) };
+            byte relative          = 0;
+            ObjCorner corner       = { -1, -1, -1 };
+            int64* cornerValues[3] = { &corner.position, &corner.uv, &corner.normal };
+            for (int32 i = 0; i < 3 && cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r'; ++i)
+            {
+                if (*cursor != '/')
+                {
+                    cursor = parseIndex(cursor, end, indices[i]);
+                    if (!cursor || indices[i] == 0)
+                    {
+                        return false;
+                    }
+                    if (indices[i] < 0)
+                    {
+                        relative |= static_cast<byte>(1 << i);
+                        *cornerValues[i] = counts[i] + indices[i];
+                    }
+                    else
+                    {
+                        *cornerValues[i] = indices[i] - 1;
+                    }
+                }
+                if (cursor < end && *cursor == '/')
+                {
+                    ++cursor;
+                }
+            }
+            if (corner.position < 0 && !(relative & 1))
+            {
+                return false;
+            }
+            face.push_back(corner);
+            faceRelative.push_back(relative);
+            cursor = skipSpaces(cursor, end);
+        }
+
+        // fan triangulation, like the default tinyobj triangulation of convex polygons
+        if (face.size() == 4)
+        {
+            chunk.quads.push_back(chunk.corners.size());
+        }
+        for (ptr_size i = 2; i < face.size(); ++i)
+        {
+            chunk.corners.insert(chunk.corners.end(), { face[0], face[i - 1], face[i] });
+            chunk.cornerRelative.insert(chunk.cornerRelative.end(), { faceRelative[0], faceRelative[i - 1], faceRelative[i] });
+        }
+        return true;
+    }
+
+    // o, g, s, usemtl, mtllib and everything else does not change the geometry
+    return true;
+}
+
+bool rayce::loadObjMeshParallel(const str& filename, MeshData& mesh)
+{
+    RAYCE_LOG_INFO("Loading: %s in parallel.", filename.c_str());
+    MappedFile file(filename);
+    if (!file.valid())
+    {
+        RAYCE_LOG_ERROR("Can not load: %s!", filename.c_str());
+        return false;
+    }
+
+    const char* data     = reinterpret_cast<const char*>(file.getData());
+    const ptr_size size  = file.getSize();
+    const ptr_size count = std::max<ptr_size>(1, std::min<ptr_size>(getWorkerCount() * 4, size / kObjChunkSize));
+
+    // chunk borders are moved to the next line start, so every line belongs to exactly one chunk
+    std::vector<ptr_size> borders(count + 1, size);
+    borders[0] = 0;
+    for (ptr_size c = 1; c < count; ++c)
+    {
+        ptr_size border = std::max(borders[c - 1], size / count * c);
+        while (border < size && data[border - 1] != '\n')
+        {
+            ++border;
+        }
+        borders[c] = border;
+    }
+
+    std::vector<ObjChunk> chunks(count);
+    parallelFor(count,
+                [&](ptr_size c)
+                {
+                    ObjChunk& chunk = chunks[c];
+                    std::vector<ObjCorner> face;
+                    std::vector<byte> faceRelative;
+                    const char* cursor = data + borders[c];
+                    const char* end    = data + borders[c + 1];
+                    while (cursor < end)
+                    {
+                        const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+                        lineEnd             = lineEnd ? lineEnd : end;
+                        if (!parseObjLine(cursor, lineEnd, chunk, face, faceRelative))
+                        {
+                            chunk.valid = false;
+                            return;
+                        }
+                        cursor = lineEnd + 1;
+                    }
+                });
+
+    // merge with per chunk offsets
+    std::vector<ptr_size> positionOffsets(count + 1, 0), normalOffsets(count + 1, 0), uvOffsets(count + 1, 0), cornerOffsets(count + 1, 0);
+    for (ptr_size c = 0; c < count; ++c)
+    {
+        if (!chunks[c].valid)
+        {
+            RAYCE_LOG_ERROR("Can not parse: %s!", filename.c_str());
+            return false;
+        }
+        positionOffsets[c + 1] = positionOffsets[c] + chunks[c].positions.size();
+        normalOffsets[c + 1]   = normalOffsets[c] + chunks[c].normals.size();
+        uvOffsets[c + 1]       = uvOffsets[c] + chunks[c].uvs.size();
+        cornerOffsets[c + 1]   = cornerOffsets[c] + chunks[c].corners.size();
+    }
+
+    const ptr_size positionCount = positionOffsets[count];
+    const ptr_size normalCount   = normalOffsets[count];
+    const ptr_size uvCount       = uvOffsets[count];
+    const ptr_size cornerCount   = cornerOffsets[count];
+    if (positionCount == 0 || cornerCount == 0)
+    {
+        RAYCE_LOG_ERROR("%s has no positions or indices!", filename.c_str());
+        return false;
+    }
+
+    // the tinyobj path only keeps normals and uvs if every corner references one
+    std::atomic<bool> allNormals{ normalCount > 0 }, allUVs{ uvCount > 0 }, inRange{ true };
+    std::vector<vec3> positions(cornerCount);
+    std::vector<vec3> normals(cornerCount);
+    std::vector<vec2> uvs(cornerCount);
+
+    parallelFor(count,
+                [&](ptr_size c)
+                {
+                    // records of all chunks are needed, find the chunk owning each index
+                    auto fetch = [&](const std::vector<ptr_size>& offsets, int64 index, auto member) -> const auto&
+                    {
+                        ptr_size owner = static_cast<ptr_size>(std::upper_bound(offsets.begin(), offsets.end(), static_cast<ptr_size>(index)) - offsets.begin() - 1);
+                        return (chunks[owner].*member)[static_cast<ptr_size>(index) - offsets[owner]];
+                    };
+
+                    // only the corners of the own chunk are modified, other chunks are just read
+                    ObjChunk& chunk = chunks[c];
+                    for (ptr_size i = 0; i < chunk.corners.size(); ++i)
+                    {
+                        ObjCorner& corner = chunk.corners[i];
+                        byte relative     = chunk.cornerRelative[i];
+                        corner.position += (relative & 1) ? static_cast<int64>(positionOffsets[c]) : 0;
+                        corner.uv += (relative & 2) ? static_cast<int64>(uvOffsets[c]) : 0;
+                        corner.normal += (relative & 4) ? static_cast<int64>(normalOffsets[c]) : 0;
+
+                        if (corner.position < 0 || corner.position >= static_cast<int64>(positionCount) || corner.uv >= static_cast<int64>(uvCount) ||
+                            corner.normal >= static_cast<int64>(normalCount) || ((relative & 2) && corner.uv < 0) || ((relative & 4) && corner.normal < 0))
+                        {
+                            inRange = false;
+                            return;
+                        }
+                    }
+
+                    // tinyobj splits quads along the shorter diagonal, the fan is (0, 1, 2), (0, 2, 3)
+                    for (ptr_size quad : chunk.quads)
+                    {
+                        ObjCorner* corners = chunk.corners.data() + quad;
+                        const vec3& p0     = fetch(positionOffsets, corners[0].position, &ObjChunk::positions);
+                        const vec3& p1     = fetch(positionOffsets, corners[1].position, &ObjChunk::positions);
+                        const vec3& p2     = fetch(positionOffsets, corners[2].position, &ObjChunk::positions);
+                        const vec3& p3     = fetch(positionOffsets, corners[5].position, &ObjChunk::positions);
+                        if (!((p2 - p0).squaredNorm() < (p3 - p1).squaredNorm()))
+                        {
+                            ObjCorner quadCorners[4] = { corners[0], corners[1], corners[2], corners[5] };
+                            corners[0]               = quadCorners[0];
+                            corners[1]               = quadCorners[1];
+                            corners[2]               = quadCorners[3];
+                            corners[3]               = quadCorners[1];
+                            corners[4]               = quadCorners[2];
+                            corners[5]               = quadCorners[3];
+                        }
+                    }
+
+                    for (ptr_size i = 0; i < chunk.corners.size(); ++i)
+                    {
+                        const ObjCorner& corner = chunk.corners[i];
+                        const ptr_size target = cornerOffsets[c] + i;
+                        positions[target]     = fetch(positionOffsets, corner.position, &ObjChunk::positions);
+                        if (corner.normal >= 0)
+                        {
+                            normals[target] = fetch(normalOffsets, corner.normal, &ObjChunk::normals);
+                        }
+                        else
+                        {
+                            allNormals = false;
+                        }
+                        if (corner.uv >= 0)
+                        {
+                            uvs[target] = fetch(uvOffsets, corner.uv, &ObjChunk::uvs);
+                        }
+                        else
+                        {
+                            allUVs = false;
+                        }
+                    }
+                });
+
+    if (!inRange)
+    {
+        RAYCE_LOG_ERROR("%s references vertex data out of range!", filename.c_str());
+        return false;
+    }
+
+    if (!allNormals)
+    {
+        normals.clear();
+    }
+    if (!allUVs)
+    {
+        uvs.clear();
+    }
+
+    mesh.indices.resize(cornerCount);
+    for (ptr_size i = 0; i < cornerCount; ++i)
+    {
+        mesh.indices[i] = static_cast<uint32>(i);
+    }
+
+    assembleVertices(positions, normals, uvs, mesh);
+    weldVertices(mesh);
+
+    return true;
+}
+
+static uint64 hashVertex(const Vertex& vertex)
+{
+    uint64 hash = hashBytes(vertex.position.data(), sizeof(float) * 3);
+    hash        = hashBytes(vertex.normal.data(), sizeof(float) * 3, hash);
+    return hashBytes(vertex.uv.data(), sizeof(float) * 2, hash);
+}
+
+static bool equalVertex(const Vertex& a, const Vertex& b)
+{
+    // bitwise, so welding never merges vertices that would shade differently
+    return std::memcmp(a.position.data(), b.position.data(), sizeof(float) * 3) == 0 && std::memcmp(a.normal.data(), b.normal.data(), sizeof(float) * 3) == 0 &&
+           std::memcmp(a.uv.data(), b.uv.data(), sizeof(float) * 2) == 0;
+}
+
+void rayce::weldVertices(MeshData& mesh)
+{
+    const ptr_size vertexCount = mesh.vertices.size();
+    if (vertexCount == 0)
+    {
+        return;
+    }
+
+    Timer timer;
+    timer.start();
+
+    // open addressing table with at most 50% load, storing indices into the welded vertices
+    ptr_size tableSize = 1;
+    while (tableSize < vertexCount * 2)
+    {
+        tableSize <<= 1;
+    }
+    const uint32 empty = std::numeric_limits<uint32>::max();
+    std::vector<uint32> table(tableSize, empty);
+
+    std::vector<uint32> remap(vertexCount);
+    std::vector<Vertex> welded;
+    welded.reserve(vertexCount);
+
+    for (ptr_size v = 0; v < vertexCount; ++v)
+    {
+        const Vertex& vertex = mesh.vertices[v];
+        ptr_size slot        = static_cast<ptr_size>(hashVertex(vertex)) & (tableSize - 1);
+        while (table[slot] != empty && !equalVertex(welded[table[slot]], vertex))
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == empty)
+        {
+            table[slot] = static_cast<uint32>(welded.size());
+            welded.push_back(vertex);
+        }
+        remap[v] = table[slot];
+    }
+
+    for (uint32& index : mesh.indices)
+    {
+        index = remap[index];
+    }
+    mesh.vertices = std::move(welded);
+
+    mesh.weldMilliseconds = static_cast<double>(timer.elapsedMicroseconds().count()) * 0.001;
+}
+
+static constexpr uint16 kSerializedFormat     = 0x041C;
+static constexpr uint32 kSerializedNormals    = 0x0001;
+static constexpr uint32 kSerializedUVs        = 0x0002;
+static constexpr uint32 kSerializedColors     = 0x0008;
+static constexpr uint32 kSerializedDouble     = 0x2000;
+static constexpr uint64 kSerializedMaxIndex32 = std::numeric_limits<uint32>::max();
+
+namespace
+{
+    /// @brief Bounds checked reader over a decompressed serialized mesh.
+    struct SerializedReader
+    {
+        const byte* data;
+        ptr_size size;
+        ptr_size offset;
+
+        template <typename T>
+        bool read(T& value)
+        {
+            if (offset + sizeof(T) > size)
+            {
+                return false;
+            }
+            std::memcpy(&value, data + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        // positions, normals and uvs are stored as float or double depending on the mesh flags
+        template <int N>
+        bool readVectors(ptr_size count, bool doublePrecision, std::vector<Eigen::Matrix<float, N, 1>>& vectors)
+        {
+            const ptr_size scalarSize = doublePrecision ? sizeof(double) : sizeof(float);
+            if (offset + count * N * scalarSize > size)
+            {
+                return false;
+            }
+
+            vectors.resize(count);
+            for (ptr_size i = 0; i < count; ++i)
+            {
+                for (int32 c = 0; c < N; ++c)
+                {
+                    if (doublePrecision)
+                    {
+                        double value;
+                        std::memcpy(&value, data + offset, sizeof(double));
+                        vectors[i][c] = static_cast<float>(value);
+                    }
+                    else
+                    {
+                        std::memcpy(&vectors[i][c], data + offset, sizeof(float));
+                    }
+                    offset += scalarSize;
+                }
+            }
+            return true;
+        }
+    };
+} // namespace
+
+bool rayce::loadSerializedMesh(const str& filename, uint32 shapeIndex, MeshData& mesh)
+{
+    RAYCE_LOG_INFO("Loading: %s (shape %u).", filename.c_str(), shapeIndex);
+
+    MappedFile file(filename);
+    if (!file.valid() || file.getSize() < 8)
+    {
+        RAYCE_LOG_ERROR("Can not open %s!", filename.c_str());
+        return false;
+    }
+
+    const byte* data    = file.getData();
+    const ptr_size size = file.getSize();
+
+    uint16 format, version;
+    std::memcpy(&format, data, sizeof(uint16));
+    std::memcpy(&version, data + sizeof(uint16), sizeof(uint16));
+    if (format != kSerializedFormat || version < 3)
+    {
+        RAYCE_LOG_ERROR("%s is not a supported serialized mesh file!", filename.c_str());
+        return false;
+    }
+
+    // the offset table at the end of the file holds the start of every mesh, followed by the mesh count
+    // version 3 stores 32 bit offsets, version 4 64 bit offsets
+    uint32 meshCount;
+    std::memcpy(&meshCount, data + size - sizeof(uint32), sizeof(uint32));
+    const ptr_size offsetSize = version >= 4 ? sizeof(uint64) : sizeof(uint32);
+    if (shapeIndex >= meshCount || static_cast<ptr_size>(meshCount) * offsetSize + sizeof(uint32) > size)
+    {
+        RAYCE_LOG_ERROR("%s has no shape %u!", filename.c_str(), shapeIndex);
+        return false;
+    }
+
+    const ptr_size tableOffset = size - sizeof(uint32) - meshCount * offsetSize;
+    auto meshOffset            = [&](uint32 index)
+    {
+        uint64 offset = 0;
+        std::memcpy(&offset, data + tableOffset + index * offsetSize, offsetSize);
+        return static_cast<ptr_size>(offset);
+    };
+
+    // every mesh starts with its own format and version, the rest up to the next mesh is one zlib stream
+    const ptr_size streamBegin = meshOffset(shapeIndex) + 2 * sizeof(uint16);
+    const ptr_size streamEnd   = shapeIndex + 1 < meshCount ? meshOffset(shapeIndex + 1) : tableOffset;
+    if (streamBegin >= streamEnd || streamEnd > tableOffset || streamEnd - streamBegin > static_cast<ptr_size>(std::numeric_limits<int32>::max()))
+    {
+        RAYCE_LOG_ERROR("%s has an invalid offset table!", filename.c_str());
+        return false;
+    }
+
+    const int32 compressedSize = static_cast<int32>(streamEnd - streamBegin);
+    int32 decompressedSize     = 0;
+    char* decompressed         = stbi_zlib_decode_malloc_guesssize_headerflag(reinterpret_cast<const char*>(data + streamBegin), compressedSize, compressedSize * 4, &decompressedSize, 1);
+    if (!decompressed)
+    {
+        RAYCE_LOG_ERROR("Can not decompress shape %u of %s!", shapeIndex, filename.c_str());
+        return false;
+    }
+
+    SerializedReader reader{ reinterpret_cast<const byte*>(decompressed), static_cast<ptr_size>(decompressedSize), 0 };
+
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec2> uvs;
+    std::vector<vec3> colors;
+
+    uint32 flags;
+    uint64 vertexCount   = 0;
+    uint64 triangleCount = 0;
+    bool valid           = reader.read(flags);
+    if (valid && version >= 4)
+    {
+        // null terminated mesh name
+        while (valid && reader.offset < reader.size && reader.data[reader.offset] != 0)
+        {
+            reader.offset++;
+        }
+        valid = reader.offset++ < reader.size;
+    }
+    valid = valid && reader.read(vertexCount) && reader.read(triangleCount) && vertexCount <= kSerializedMaxIndex32;
+
+    const bool doublePrecision = (flags & kSerializedDouble) != 0;
+    valid                      = valid && reader.readVectors<3>(vertexCount, doublePrecision, positions);
+    if (valid && (flags & kSerializedNormals))
+    {
+        valid = reader.readVectors<3>(vertexCount, doublePrecision, normals);
+    }
+    if (valid && (flags & kSerializedUVs))
+    {
+        valid = reader.readVectors<2>(vertexCount, doublePrecision, uvs);
+    }
+    if (valid && (flags & kSerializedColors))
+    {
+        // vertex colors are not used, they only have to be skipped
+        valid = reader.readVectors<3>(vertexCount, doublePrecision, colors);
+    }
+
+    if (valid)
+    {
+        const ptr_size indexCount = triangleCount * 3;
+        valid                     = reader.offset + indexCount * sizeof(uint32) <= reader.size;
+        if (valid)
+        {
+            mesh.indices.resize(indexCount);
+            std::memcpy(mesh.indices.data(), reader.data + reader.offset, indexCount * sizeof(uint32));
+            for (uint32 index : mesh.indices)
+            {
+                valid = valid && index < vertexCount;
+            }
+        }
+    }
+
+    stbi_image_free(decompressed);
+
+    if (!valid || positions.empty() || mesh.indices.empty())
+    {
+        RAYCE_LOG_ERROR("Shape %u of %s is corrupted!", shapeIndex, filename.c_str());
+        mesh.indices.clear();
+        return false;
+    }
+
+    // serialized meshes are indexed already, no welding needed
+    assembleVertices(positions, normals, uvs, mesh);
+
+    return true;
+}
+
+static uint32 encodeOctahedralNormal(const vec3& normal)
+{
+    const float length = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+    if (length <= 0.0f)
+    {
+        return COMPACT_NORMAL_NONE;
+    }
+
+    // project onto the octahedron and fold the lower hemisphere over the diagonals
+    vec2 e = vec2(normal.x(), normal.y()) / length;
+    if (normal.z() < 0.0f)
+    {
+        e = vec2((1.0f - std::abs(e.y())) * (e.x() >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(e.x())) * (e.y() >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    const int32 x = static_cast<int32>(std::round(std::clamp(e.x(), -1.0f, 1.0f) * 32767.0f));
+    const int32 y = static_cast<int32>(std::round(std::clamp(e.y(), -1.0f, 1.0f) * 32767.0f));
+    return (static_cast<uint32>(x) & 0xFFFF) | (static_cast<uint32>(y) << 16);
+}
+
+static uint32 encodeHalf2(const vec2& value)
+{
+    const uint16 x = Eigen::numext::bit_cast<uint16>(Eigen::half(value.x()));
+    const uint16 y = Eigen::numext::bit_cast<uint16>(Eigen::half(value.y()));
+    return static_cast<uint32>(x) | (static_cast<uint32>(y) << 16);
+}
+
+bool rayce::splitVertexStreams(std::span<const Vertex> vertices, bool withAttributes, bool compact, std::vector<vec3>& positions, std::vector<VertexAttributes>& attributes,
+                               std::vector<CompactVertexAttributes>& compactAttributes)
+{
+    positions.resize(vertices.size());
+    attributes.clear();
+    compactAttributes.clear();
+
+    for (ptr_size i = 0; i < vertices.size(); ++i)
+    {
+        positions[i] = vertices[i].position;
+    }
+
+    // proxies without normals and uvs are shaded with the geometry normal and need no attribute stream
+    if (!withAttributes || vertices.empty())
+    {
+        return false;
+    }
+
+    if (compact)
+    {
+        compactAttributes.resize(vertices.size());
+        for (ptr_size i = 0; i < vertices.size(); ++i)
+        {
+            compactAttributes[i].normal = encodeOctahedralNormal(vertices[i].normal);
+            compactAttributes[i].uv     = encodeHalf2(vertices[i].uv);
+        }
+        return true;
+    }
+
+    attributes.resize(vertices.size());
+    for (ptr_size i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex& vertex        = vertices[i];
+        VertexAttributes& attribute = attributes[i];
+        attribute.normal[0]         = vertex.normal.x();
+        attribute.normal[1]         = vertex.normal.y();
+        attribute.normal[2]         = vertex.normal.z();
+        attribute.uv[0]             = vertex.uv.x();
+        attribute.uv[1]             = vertex.uv.y();
+    }
+    return true;
+}
+
+// the miss model is a direct mapped 32 KiB cache with 64 byte lines, roughly a L1 of current GPUs
+static constexpr uint64 kCacheLineSize  = 64;
+static constexpr uint64 kCacheLineCount = 512;
+
+namespace
+{
+    /// @brief Direct mapped cache model counting line misses.
+    struct CacheModel
+    {
+        std::vector<uint64> tags = std::vector<uint64>(kCacheLineCount, std::numeric_limits<uint64>::max());
+        uint64 misses            = 0;
+
+        void access(uint64 address, uint64 size)
+        {
+            for (uint64 line = address / kCacheLineSize; line <= (address + size - 1) / kCacheLineSize; ++line)
+            {
+                uint64& tag = tags[line % kCacheLineCount];
+                if (tag != line)
+                {
+                    tag = line;
+                    misses++;
+                }
+            }
+        }
+    };
+} // namespace
+
+// spreads the lower 21 bits of value so that two zero bits follow every bit
+static uint64 expandBits21(uint64 value)
+{
+    value &= 0x1FFFFF;
+    value = (value | value << 32) & 0x1F00000000FFFF;
+    value = (value | value << 16) & 0x1F0000FF0000FF;
+    value = (value | value << 8) & 0x100F00F00F00F00F;
+    value = (value | value << 4) & 0x10C30C30C30C30C3;
+    value = (value | value << 2) & 0x1249249249249249;
+    return value;
+}
+
+static std::vector<uint32> spatialTriangleOrder(std::span<const Vertex> vertices, std::span<const uint32> indices, const AxisAlignedBoundingBox& bounds)
+{
+    const ptr_size triangleCount = indices.size() / 3;
+    const vec3 extent            = (bounds.maximum - bounds.minimum).cwiseMax(vec3::Constant(std::numeric_limits<float>::min()));
+    const float scale            = static_cast<float>((1 << 21) - 1);
+
+    std::vector<std::pair<uint64, uint32>> codes(triangleCount);
+    parallelFor(triangleCount,
+                [&](ptr_size t)
+                {
+                    const vec3 centroid = (vertices[indices[t * 3]].position + vertices[indices[t * 3 + 1]].position + vertices[indices[t * 3 + 2]].position) / 3.0f;
+                    const vec3 unit     = ((centroid - bounds.minimum).cwiseQuotient(extent)).cwiseMax(vec3::Zero()).cwiseMin(vec3::Ones());
+                    const uint64 code   = expandBits21(static_cast<uint64>(unit.x() * scale)) | (expandBits21(static_cast<uint64>(unit.y() * scale)) << 1) |
+                                        (expandBits21(static_cast<uint64>(unit.z() * scale)) << 2);
+                    codes[t] = { code, static_cast<uint32>(t) };
+                });
+
+    // the triangle index breaks ties, so the order is deterministic
+    std::sort(codes.begin(), codes.end());
+
+    std::vector<uint32> order(triangleCount);
+    for (ptr_size t = 0; t < triangleCount; ++t)
+    {
+        order[t] = codes[t].second;
+    }
+    return order;
+}
+
+float rayce::estimateCacheMisses(std::span<const uint32> indices, std::span<const uint32> accessOrder)
+{
+    const ptr_size triangleCount = accessOrder.size();
+    if (triangleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    // the three streams getTriangle reads from, placed after each other in the address space
+    uint64 vertexCount = 0;
+    for (uint32 index : indices)
+    {
+        vertexCount = std::max<uint64>(vertexCount, static_cast<uint64>(index) + 1);
+    }
+    const uint64 positionBase  = indices.size_bytes();
+    const uint64 attributeBase = positionBase + vertexCount * sizeof(vec3);
+
+    CacheModel cache;
+    for (uint32 t : accessOrder)
+    {
+        cache.access(static_cast<uint64>(t) * 3 * sizeof(uint32), 3 * sizeof(uint32));
+        for (int32 i = 0; i < 3; ++i)
+        {
+            const uint64 vertex = indices[static_cast<ptr_size>(t) * 3 + i];
+            cache.access(positionBase + vertex * sizeof(vec3), sizeof(vec3));
+            cache.access(attributeBase + vertex * sizeof(VertexAttributes), sizeof(VertexAttributes));
+        }
+    }
+
+    return static_cast<float>(cache.misses) / static_cast<float>(triangleCount);
+}
+
+void rayce::optimizeTriangleOrder(MeshData& mesh)
+{
+    const ptr_size triangleCount = mesh.indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // spatially close triangles are hit by neighbouring rays, so the Morton order of the centroids is the expected access order
+    std::vector<uint32> order = spatialTriangleOrder(mesh.vertices, mesh.indices, mesh.bounds);
+    mesh.cacheMissesBefore    = estimateCacheMisses(mesh.indices, order);
+
+    const uint32 unused = std::numeric_limits<uint32>::max();
+    std::vector<uint32> remap(mesh.vertices.size(), unused);
+    std::vector<Vertex> vertices;
+    std::vector<uint32> indices(mesh.indices.size());
+    vertices.reserve(mesh.vertices.size());
+
+    for (ptr_size t = 0; t < triangleCount; ++t)
+    {
+        for (int32 i = 0; i < 3; ++i)
+        {
+            const uint32 index = mesh.indices[static_cast<ptr_size>(order[t]) * 3 + i];
+            if (remap[index] == unused)
+            {
+                remap[index] = static_cast<uint32>(vertices.size());
+                vertices.push_back(mesh.vertices[index]);
+            }
+            indices[t * 3 + i] = remap[index];
+        }
+    }
+
+    // unreferenced vertices are kept at the end, the vertex count does not change
+    for (ptr_size v = 0; v < mesh.vertices.size(); ++v)
+    {
+        if (remap[v] == unused)
+        {
+            vertices.push_back(mesh.vertices[v]);
+        }
+    }
+
+    mesh.vertices = std::move(vertices);
+    mesh.indices  = std::move(indices);
+
+    // after the reorder the storage order is the access order
+    std::iota(order.begin(), order.end(), 0);
+    mesh.cacheMissesAfter = estimateCacheMisses(mesh.indices, order);
+}
+
+void rayce::splitMeshChunks(const MeshData& mesh, uint32 maxTriangles, std::vector<MeshData>& chunks)
+{
+    std::span<const Vertex> vertices = mesh.getVertices();
+    std::span<const uint32> indices  = mesh.getIndices();
+    const ptr_size triangleCount     = indices.size() / 3;
+
+    std::vector<vec3> centroids(triangleCount);
+    parallelFor(triangleCount, [&](ptr_size t) { centroids[t] = (vertices[indices[t * 3]].position + vertices[indices[t * 3 + 1]].position + vertices[indices[t * 3 + 2]].position) / 3.0f; });
+
+    std::vector<uint32> triangles(triangleCount);
+    std::iota(triangles.begin(), triangles.end(), 0);
+
+    // ranges are split depth first and the lower half is taken first, so neighbouring chunks are spatially close
+    std::vector<std::pair<ptr_size, ptr_size>> ranges;
+    std::vector<std::pair<ptr_size, ptr_size>> stack = { { 0, triangleCount } };
+    while (!stack.empty())
+    {
+        auto [begin, end] = stack.back();
+        stack.pop_back();
+
+        if (end - begin <= std::max<uint32>(maxTriangles, 1))
+        {
+            ranges.push_back({ begin, end });
+            continue;
+        }
+
+        vec3 minimum = vec3::Constant(std::numeric_limits<float>::max());
+        vec3 maximum = vec3::Constant(std::numeric_limits<float>::lowest());
+        for (ptr_size t = begin; t < end; ++t)
+        {
+            minimum = minimum.cwiseMin(centroids[triangles[t]]);
+            maximum = maximum.cwiseMax(centroids[triangles[t]]);
+        }
+        int32 axis;
+        (maximum - minimum).maxCoeff(&axis);
+
+        const ptr_size middle = begin + (end - begin) / 2;
+        std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+                         [&centroids, axis](uint32 a, uint32 b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        stack.push_back({ middle, end });
+        stack.push_back({ begin, middle });
+    }
+
+    const uint32 unused = std::numeric_limits<uint32>::max();
+    std::vector<uint32> remap(vertices.size(), unused);
+
+    chunks.clear();
+    chunks.resize(ranges.size());
+    for (ptr_size c = 0; c < ranges.size(); ++c)
+    {
+        auto [begin, end] = ranges[c];
+        MeshData& chunk   = chunks[c];
+        chunk.hasUVs      = mesh.hasUVs;
+        chunk.hasNormals  = mesh.hasNormals;
+
+        // keep the triangle order of the source, it may already be optimized
+        std::sort(triangles.begin() + begin, triangles.begin() + end);
+
+        chunk.indices.reserve((end - begin) * 3);
+        for (ptr_size t = begin; t < end; ++t)
+        {
+            for (int32 i = 0; i < 3; ++i)
+            {
+                const uint32 index = indices[static_cast<ptr_size>(triangles[t]) * 3 + i];
+                if (remap[index] == unused)
+                {
+                    remap[index] = static_cast<uint32>(chunk.vertices.size());
+                    chunk.vertices.push_back(vertices[index]);
+                }
+                chunk.indices.push_back(remap[index]);
+            }
+        }
+
+        chunk.bounds.minimum = vec3::Constant(std::numeric_limits<float>::max());
+        chunk.bounds.maximum = vec3::Constant(std::numeric_limits<float>::lowest());
+        for (const Vertex& vertex : chunk.vertices)
+        {
+            chunk.bounds.minimum = chunk.bounds.minimum.cwiseMin(vertex.position);
+            chunk.bounds.maximum = chunk.bounds.maximum.cwiseMax(vertex.position);
+        }
+
+        // only the touched entries are reset, a full reset per chunk would be quadratic
+        for (ptr_size t = begin; t < end; ++t)
+        {
+            for (int32 i = 0; i < 3; ++i)
+            {
+                remap[indices[static_cast<ptr_size>(triangles[t]) * 3 + i]] = unused;
+            }
+        }
+    }
+}
+
+void rayce::appendTransformedMesh(const MeshData& mesh, const mat4& transformation, MeshData& target)
+{
+    std::span<const Vertex> vertices = mesh.getVertices();
+    std::span<const uint32> indices  = mesh.getIndices();
+
+    if (target.vertices.empty())
+    {
+        target.bounds.minimum = vec3::Constant(std::numeric_limits<float>::max());
+        target.bounds.maximum = vec3::Constant(std::numeric_limits<float>::lowest());
+    }
+
+    const mat3 linear       = transformation.block<3, 3>(0, 0);
+    const mat3 normalMatrix = linear.inverse().transpose();
+    const bool mirrored     = linear.determinant() < 0.0f;
+    const uint32 offset     = static_cast<uint32>(target.vertices.size());
+
+    target.vertices.reserve(target.vertices.size() + vertices.size());
+    for (const Vertex& vertex : vertices)
+    {
+        Vertex transformed   = vertex;
+        transformed.position = (transformation * vertex.position.homogeneous()).head<3>();
+        // zero normals mark vertices without normals and stay zero
+        if (!vertex.normal.isZero())
+        {
+            transformed.normal = (normalMatrix * vertex.normal).normalized();
+        }
+        target.bounds.minimum = target.bounds.minimum.cwiseMin(transformed.position);
+        target.bounds.maximum = target.bounds.maximum.cwiseMax(transformed.position);
+        target.vertices.push_back(transformed);
+    }
+
+    target.indices.reserve(target.indices.size() + indices.size());
+    for (ptr_size t = 0; t + 2 < indices.size(); t += 3)
+    {
+        target.indices.push_back(offset + indices[t]);
+        target.indices.push_back(offset + indices[t + (mirrored ? 2 : 1)]);
+        target.indices.push_back(offset + indices[t + (mirrored ? 1 : 2)]);
+    }
+
+    target.hasUVs     = target.hasUVs || mesh.hasUVs;
+    target.hasNormals = target.hasNormals || mesh.hasNormals;
+    target.sourceVertexCount += mesh.sourceVertexCount;
+}
+
+void rayce::cleanupMesh(MeshData& mesh)
+{
+    const ptr_size triangleCount = mesh.indices.size() / 3;
+    mesh.sourceTriangleCount     = static_cast<uint32>(triangleCount);
+
+    // sin of the angle between two edges below which a triangle has no area in float precision
+    const float minimumSine = 1e-6f;
+
+    const uint32 vertexCount = static_cast<uint32>(mesh.vertices.size());
+    std::vector<byte> keep(triangleCount, 0);
+    parallelFor(triangleCount,
+                [&](ptr_size t)
+                {
+                    const uint32 a = mesh.indices[t * 3], b = mesh.indices[t * 3 + 1], c = mesh.indices[t * 3 + 2];
+                    if (a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c)
+                    {
+                        return;
+                    }
+                    const vec3 e1 = mesh.vertices[b].position - mesh.vertices[a].position;
+                    const vec3 e2 = mesh.vertices[c].position - mesh.vertices[a].position;
+                    keep[t]       = e1.cross(e2).squaredNorm() > minimumSine * minimumSine * e1.squaredNorm() * e2.squaredNorm() ? 1 : 0;
+                });
+
+    // rotate every triangle so the smallest index comes first, equal rotations are the same face with the same winding
+    std::vector<std::pair<std::array<uint32, 3>, uint32>> faces;
+    faces.reserve(triangleCount);
+    for (ptr_size t = 0; t < triangleCount; ++t)
+    {
+        if (!keep[t])
+        {
+            continue;
+        }
+        std::array<uint32, 3> face = { mesh.indices[t * 3], mesh.indices[t * 3 + 1], mesh.indices[t * 3 + 2] };
+        std::rotate(face.begin(), std::min_element(face.begin(), face.end()), face.end());
+        faces.push_back({ face, static_cast<uint32>(t) });
+    }
+    // the triangle index breaks ties, so the first occurrence is kept
+    std::sort(faces.begin(), faces.end());
+    for (ptr_size f = 1; f < faces.size(); ++f)
+    {
+        if (faces[f].first == faces[f - 1].first)
+        {
+            keep[faces[f].second] = 0;
+        }
+    }
+
+    const uint32 unused = std::numeric_limits<uint32>::max();
+    std::vector<uint32> remap(mesh.vertices.size(), unused);
+    ptr_size keptIndices = 0;
+    for (ptr_size t = 0; t < triangleCount; ++t)
+    {
+        if (!keep[t])
+        {
+            continue;
+        }
+        for (int32 i = 0; i < 3; ++i)
+        {
+            const uint32 index          = mesh.indices[t * 3 + i];
+            remap[index]                = 0;
+            mesh.indices[keptIndices++] = index;
+        }
+    }
+    mesh.indices.resize(keptIndices);
+
+    // referenced vertices keep their order
+    ptr_size keptVertices = 0;
+    for (ptr_size v = 0; v < mesh.vertices.size(); ++v)
+    {
+        if (remap[v] != unused)
+        {
+            remap[v]                      = static_cast<uint32>(keptVertices);
+            mesh.vertices[keptVertices++] = mesh.vertices[v];
+        }
+    }
+    if (keptVertices == mesh.vertices.size())
+    {
+        return;
+    }
+
+    mesh.vertices.resize(keptVertices);
+    for (uint32& index : mesh.indices)
+    {
+        index = remap[index];
+    }
+
+    mesh.bounds.minimum = vec3::Constant(std::numeric_limits<float>::max());
+    mesh.bounds.maximum = vec3::Constant(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : mesh.vertices)
+    {
+        mesh.bounds.minimum = mesh.bounds.minimum.cwiseMin(vertex.position);
+        mesh.bounds.maximum = mesh.bounds.maximum.cwiseMax(vertex.position);
+    }
+}
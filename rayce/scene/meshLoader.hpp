@@ -0,0 +1,168 @@
+/// @file      meshLoader.hpp
+/// @author    Paul Himmler
+/// @version   0.01
+/// @date      2024
+/// @copyright Apache License 2.0
+
+#pragma once
+
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include <core/mappedFile.hpp>
+#include <hostDeviceInterop.slang>
+#include <span>
+
+namespace rayce
+{
+    /// @brief CPU side triangle mesh data ready to be uploaded to the GPU.
+    struct MeshData
+    {
+        /// @brief The interleaved vertices.
+        std::vector<Vertex> vertices;
+        /// @brief The triangle indices.
+        std::vector<uint32> indices;
+        /// @brief True if the source file provided texture coordinates, else False.
+        bool hasUVs{ false };
+        /// @brief True if the source file provided vertex normals, else False.
+        bool hasNormals{ false };
+        /// @brief The number of vertices emitted by the source file before welding.
+        uint32 sourceVertexCount{ 0 };
+        /// @brief The number of triangles before @a cleanupMesh, 0 if it was not applied.
+        uint32 sourceTriangleCount{ 0 };
+        /// @brief The object space bounds of all vertices.
+        AxisAlignedBoundingBox bounds;
+        /// @brief The time spent in @a weldVertices in milliseconds.
+        double weldMilliseconds{ 0.0 };
+        /// @brief The estimated cache line misses per triangle before @a optimizeTriangleOrder, 0 if it was not applied.
+        float cacheMissesBefore{ 0.0f };
+        /// @brief The estimated cache line misses per triangle after @a optimizeTriangleOrder, 0 if it was not applied.
+        float cacheMissesAfter{ 0.0f };
+
+        /// @brief Memory mapped cache entry, if set the vertex and index data is read from it instead of the vectors.
+        std::shared_ptr<MappedFile> mappedFile;
+        /// @brief The vertices inside @a mappedFile.
+        std::span<const Vertex> mappedVertices;
+        /// @brief The indices inside @a mappedFile.
+        std::span<const uint32> mappedIndices;
+
+        /// @brief Retrieves the vertices, either from the mapped cache entry or the vector.
+        /// @return The vertices of the mesh.
+        std::span<const Vertex> getVertices() const
+        {
+            return mappedFile ? mappedVertices : std::span<const Vertex>(vertices);
+        }
+
+        /// @brief Retrieves the indices, either from the mapped cache entry or the vector.
+        /// @return The indices of the mesh.
+        std::span<const uint32> getIndices() const
+        {
+            return mappedFile ? mappedIndices : std::span<const uint32>(indices);
+        }
+    };
+
+    /// @brief Loads a triangle mesh from a ply file.
+    /// @details Thread safe, can be called from worker threads.
+    /// @param[in] filename The ply file to load.
+    /// @param[out] mesh The @a MeshData to fill.
+    /// @return True on success, else False.
+    bool loadPlyMesh(const str& filename, MeshData& mesh);
+
+    /// @brief Loads a triangle mesh from an obj file.
+    /// @details Thread safe, can be called from worker threads.
+    /// One vertex is emitted per face corner, identical corners are merged by @a weldVertices.
+    /// Large files are parsed by @a loadObjMeshParallel.
+    /// @param[in] filename The obj file to load.
+    /// @param[out] mesh The @a MeshData to fill.
+    /// @return True on success, else False.
+    bool loadObjMesh(const str& filename, MeshData& mesh);
+
+    /// @brief Loads a triangle mesh from an obj file with a multithreaded parser.
+    /// @details Thread safe, can be called from worker threads.
+    /// The mapped file is split into line aligned chunks which are parsed concurrently, the v, vn, vt and f records
+    /// are merged with per chunk offsets afterwards. Quads are split along the shorter diagonal like tinyobj does,
+    /// larger polygons are fan triangulated, everything else is ignored.
+    /// @param[in] filename The obj file to load.
+    /// @param[out] mesh The @a MeshData to fill.
+    /// @return True on success, else False.
+    bool loadObjMeshParallel(const str& filename, MeshData& mesh);
+
+    /// @brief Loads one triangle mesh from a Mitsuba serialized file.
+    /// @details Thread safe, can be called from worker threads.
+    /// The file is memory mapped, the offset table at its end locates the zlib stream of the requested mesh so only that
+    /// one is decompressed. Loading several shapes of the same file from worker threads decompresses them in parallel.
+    /// Vertex colors are skipped, 64 bit indices are not supported.
+    /// @param[in] filename The serialized file to load.
+    /// @param[in] shapeIndex The index of the mesh inside the file.
+    /// @param[out] mesh The @a MeshData to fill.
+    /// @return True on success, else False.
+    bool loadSerializedMesh(const str& filename, uint32 shapeIndex, MeshData& mesh);
+
+    /// @brief Merges vertices with identical position, normal and uv and remaps the indices.
+    /// @details The first occurrence of a vertex is kept, so the vertex order stays stable.
+    /// @param[in,out] mesh The @a MeshData to weld, has to hold its data in the vectors.
+    void weldVertices(MeshData& mesh);
+
+    /// @brief Removes degenerate and duplicate triangles and compacts the vertices to the referenced ones.
+    /// @details Triangles are degenerate if two indices are equal or the area is zero within float precision. Triangles with indices
+    /// out of range are removed as well. Duplicates are triangles with the same indices and winding, flipped copies are kept.
+    /// The bounds are recomputed if vertices were removed. The result is empty if no triangle is left.
+    /// @param[in,out] mesh The @a MeshData to clean up, has to hold its data in the vectors.
+    void cleanupMesh(MeshData& mesh);
+
+    /// @brief Reorders the triangles along a Morton curve of their centroids and the vertices in order of first use.
+    /// @details Rays hitting neighbouring triangles then read neighbouring index and vertex data. The estimated cache misses
+    /// before and after are stored in the mesh. Unreferenced vertices are moved to the end.
+    /// @param[in,out] mesh The @a MeshData to optimize, has to hold its data in the vectors.
+    void optimizeTriangleOrder(MeshData& mesh);
+
+    /// @brief Estimates the cache line misses per triangle when fetching triangles in the given order.
+    /// @details Models a direct mapped 32 KiB cache with 64 byte lines over the index, position and attribute streams
+    /// the closest hit shader reads.
+    /// @param[in] indices The triangle indices.
+    /// @param[in] accessOrder The triangle indices in the order they are fetched.
+    /// @return The average number of missed cache lines per fetched triangle.
+    float estimateCacheMisses(std::span<const uint32> indices, std::span<const uint32> accessOrder);
+
+    /// @brief Partitions a mesh into spatially coherent chunks of at most @p maxTriangles triangles.
+    /// @details The triangles are split recursively at the median centroid along the largest extent of the centroid bounds,
+    /// so chunks hold between half and all of @p maxTriangles triangles. Every chunk only holds the vertices it references,
+    /// triangles keep their relative order.
+    /// @param[in] mesh The @a MeshData to split.
+    /// @param[in] maxTriangles The maximum number of triangles per chunk.
+    /// @param[out] chunks The chunks, holding their data in the vectors.
+    void splitMeshChunks(const MeshData& mesh, uint32 maxTriangles, std::vector<MeshData>& chunks);
+
+    /// @brief Bakes a transformation into the vertices of a mesh and appends them to another mesh.
+    /// @details Normals are transformed with the inverse transpose, for mirroring transformations the winding is flipped so
+    /// geometric normals keep their orientation. The bounds of @p target are extended.
+    /// @param[in] mesh The @a MeshData to append.
+    /// @param[in] transformation The transformation to bake into the appended vertices.
+    /// @param[in,out] target The @a MeshData to append to, has to hold its data in the vectors.
+    void appendTransformedMesh(const MeshData& mesh, const mat4& transformation, MeshData& target);
+
+    /// @brief Transforms object space bounds by transforming their 8 corners.
+    /// @details The result encloses the transformed vertices without touching them, for rotations it can be slightly larger
+    /// than the bounds of the transformed vertices.
+    /// @param[in] bounds The object space bounds.
+    /// @param[in] transformation The object to world transformation.
+    /// @return The world space bounds.
+    AxisAlignedBoundingBox transformBounds(const AxisAlignedBoundingBox& bounds, const mat4& transformation);
+
+    /// @brief Splits vertices into a tightly packed position stream for the BLAS build and an attribute stream for shading.
+    /// @details With @p compact set the normals are octahedral encoded in 32 bits and the uvs are stored as half floats in
+    /// @p compactAttributes, else @p attributes holds them at full precision. Zero normals are encoded as COMPACT_NORMAL_NONE.
+    /// Meshes whose source provided neither normals nor uvs, like shadow proxies, are split with @p withAttributes unset and get no
+    /// attribute stream at all.
+    /// @param[in] vertices The vertices to split.
+    /// @param[in] withAttributes True if an attribute stream should be written, usually @a MeshData::hasNormals or @a MeshData::hasUVs.
+    /// @param[in] compact True if @a CompactVertexAttributes should be written, else False.
+    /// @param[out] positions The vertex positions.
+    /// @param[out] attributes The full precision attributes, empty if @p compact or @p withAttributes is not set.
+    /// @param[out] compactAttributes The compact attributes, empty if @p compact or @p withAttributes is not set.
+    /// @return True if an attribute stream was written, else False.
+    bool splitVertexStreams(std::span<const Vertex> vertices, bool withAttributes, bool compact, std::vector<vec3>& positions, std::vector<VertexAttributes>& attributes,
+                            std::vector<CompactVertexAttributes>& compactAttributes);
+} // namespace rayce
+
+#endif // MESH_LOADER_HPP
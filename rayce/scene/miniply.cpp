@@ -32,8 +32,21 @@ SOFTWARE.
 #include <cstring>
 #include <string>
 
-#ifndef _WIN32
+#include <core/parallel.hpp>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
 #include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 
@@ -55,6 +68,12 @@ namespace miniply {
   static constexpr uint32_t kPLYReadBufferSize = 128 * 1024;
   static constexpr uint32_t kPLYTempBufferSize = kPLYReadBufferSize;
 
+  // Fixed size binary little-endian elements at least this big are memory
+  // mapped instead of being copied through the read buffer.
+  static constexpr size_t kPLYMinMappedElementSize = 8 * kPLYReadBufferSize;
+  // Minimum number of rows each thread handles when extracting properties.
+  static constexpr uint32_t kPLYMinRowsPerThread = 32 * 1024;
+
   static const char* kPLYFileTypes[] = { "ascii", "binary_little_endian", "binary_big_endian", nullptr };
   static const uint32_t kPLYPropertySize[]= { 1, 1, 2, 2, 4, 4, 4, 8 };
 
@@ -196,6 +215,126 @@ namespace miniply {
   }
 
 
+  static inline int64_t file_tell(FILE* file)
+  {
+  #ifdef _WIN32
+    return _ftelli64(file);
+  #else
+    return static_cast<int64_t>(ftello(file));
+  #endif
+  }
+
+
+  // Maps the whole file read-only. `handle` receives the OS object that has to
+  // be passed to `file_unmap` together with the returned data.
+  static bool file_map(FILE* file, const uint8_t** data, size_t* size, void** handle)
+  {
+  #ifdef _WIN32
+    HANDLE fileHandle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    LARGE_INTEGER fileSize;
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+      return false;
+    }
+    HANDLE mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+      return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+      CloseHandle(mapping);
+      return false;
+    }
+    *data = static_cast<const uint8_t*>(view);
+    *size = static_cast<size_t>(fileSize.QuadPart);
+    *handle = mapping;
+    return true;
+  #else
+    int fd = fileno(file);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+      return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+      return false;
+    }
+    *data = static_cast<const uint8_t*>(view);
+    *size = static_cast<size_t>(fileStat.st_size);
+    *handle = nullptr;
+    return true;
+  #endif
+  }
+
+
+  static void file_unmap(const uint8_t* data, size_t size, void* handle)
+  {
+  #ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(handle));
+  #else
+    (void)handle;
+    munmap(const_cast<uint8_t*>(data), size);
+  #endif
+  }
+
+
+  // Splits `numRows` rows into contiguous slices and calls `func(firstRow, endRow)`
+  // for each of them on the rayce worker pool. Small row counts are handled on
+  // the calling thread, and so are all slices if the file is already parsed on
+  // a worker of another parallelFor (e.g. the scene loader), which avoids
+  // nested oversubscription.
+  template <class Func>
+  static void for_each_row_slice(uint32_t numRows, Func&& func)
+  {
+    uint32_t numSlices = rayce::getWorkerCount();
+    if (numSlices > numRows / kPLYMinRowsPerThread) {
+      numSlices = numRows / kPLYMinRowsPerThread;
+    }
+    if (numSlices < 2 || rayce::insideParallelFor()) {
+      func(0u, numRows);
+      return;
+    }
+
+    rayce::parallelFor(numSlices, [&func, numRows, numSlices](size_t slice) {
+      uint32_t firstRow = static_cast<uint32_t>(uint64_t(numRows) * slice / numSlices);
+      uint32_t endRow = static_cast<uint32_t>(uint64_t(numRows) * (slice + 1) / numSlices);
+      func(firstRow, endRow);
+    });
+  }
+
+
+  // Copies `N` bytes per row. With a compile time size the copy reduces to a
+  // few unaligned loads and stores instead of a memcpy call per row.
+  template <size_t N>
+  static void copy_rows(uint8_t* to, size_t destStride, const uint8_t* from, size_t srcStride, uint32_t numRows)
+  {
+    for (uint32_t row = 0; row < numRows; row++) {
+      std::memcpy(to, from, N);
+      from += srcStride;
+      to += destStride;
+    }
+  }
+
+
+  static void copy_rows(uint8_t* to, size_t destStride, const uint8_t* from, size_t srcStride, size_t numBytes, uint32_t numRows)
+  {
+    switch (numBytes) {
+    case 4:  copy_rows<4>(to, destStride, from, srcStride, numRows); break;
+    case 8:  copy_rows<8>(to, destStride, from, srcStride, numRows); break;
+    case 12: copy_rows<12>(to, destStride, from, srcStride, numRows); break;
+    case 16: copy_rows<16>(to, destStride, from, srcStride, numRows); break;
+    default:
+      for (uint32_t row = 0; row < numRows; row++) {
+        std::memcpy(to, from, numBytes);
+        from += srcStride;
+        to += destStride;
+      }
+      break;
+    }
+  }
+
+
   static bool int_literal(const char* start, char const** end, int* val)
   {
     const char* pos = start;
@@ -626,6 +765,9 @@ namespace miniply {
 
   PLYReader::~PLYReader()
   {
+    if (m_mapData != nullptr) {
+      file_unmap(m_mapData, m_mapSize, m_mapHandle);
+    }
     if (m_f != nullptr) {
       fclose(m_f);
     }
@@ -690,6 +832,7 @@ namespace miniply {
 
       // Clear temporary storage for the non-list properties in the current element.
       m_elementData.clear();
+      m_elementView = nullptr;
       m_elementLoaded = false;
       return;
     }
@@ -938,63 +1081,59 @@ namespace miniply {
       }
     }
 
-    uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-    if (!conversionRequired) {
-      // If no data conversion is required, we can just use memcpy to get
-      // values into dest.
-      if (contiguousRows) {
-        // Most efficient case is when the rows are contiguous. It means we're
-        // simply copying the entire data block for this element, which we can
-        // do with a single memcpy.
-        std::memcpy(to, m_elementData.data(), m_elementData.size());
-      }
-      else if (contiguousCols) {
-        // If the rows aren't contiguous, but the columns we're extracting
-        // within each row are, then we can do a single memcpy per row.
-        const uint8_t* from = m_elementData.data() + elem->properties[propIdxs[0]].offset;
-        const uint8_t* end = m_elementData.data() + m_elementData.size();
-        const size_t numBytes = expectedOffset - elem->properties[propIdxs[0]].offset;
-        while (from < end) {
-          std::memcpy(to, from, numBytes);
-          from += elem->rowStride;
-          to += numBytes;
+    const uint8_t* data = element_data();
+    const size_t srcStride = elem->rowStride;
+    const size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
+    const size_t destStride = numProps * colBytes;
+
+    // Rows are independent, so large elements are extracted in parallel slices.
+    for_each_row_slice(elem->count, [&](uint32_t firstRow, uint32_t endRow) {
+      const uint8_t* row = data + firstRow * srcStride;
+      uint8_t* to = reinterpret_cast<uint8_t*>(dest) + firstRow * destStride;
+      const uint32_t numRows = endRow - firstRow;
+      if (!conversionRequired) {
+        // If no data conversion is required, we can just use memcpy to get
+        // values into dest.
+        if (contiguousRows) {
+          // Most efficient case is when the rows are contiguous. It means we're
+          // simply copying the entire data block for this element, which we can
+          // do with a single memcpy.
+          std::memcpy(to, row, numRows * srcStride);
+        }
+        else if (contiguousCols) {
+          // If the rows aren't contiguous, but the columns we're extracting
+          // within each row are, then we can do a single memcpy per row.
+          const uint32_t firstOffset = elem->properties[propIdxs[0]].offset;
+          copy_rows(to, destStride, row + firstOffset, srcStride, expectedOffset - firstOffset, numRows);
+        }
+        else {
+          // If the columns aren't contiguous, we must memcpy each one separately.
+          for (uint32_t r = 0; r < numRows; r++) {
+            for (uint32_t i = 0; i < numProps; i++) {
+              uint32_t propIdx = propIdxs[i];
+              const PLYProperty& prop = elem->properties[propIdx];
+              std::memcpy(to, row + prop.offset, colBytes);
+              to += colBytes;
+            }
+            row += srcStride;
+          }
         }
       }
       else {
-        // If the columns aren't contiguous, we must memcpy each one separately.
-        const uint8_t* row = m_elementData.data();
-        const uint8_t* end = m_elementData.data() + m_elementData.size();
-        uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-        size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
-        while (row < end) {
+        // We will have to do data type conversions on the column values here. We
+        // cannot simply use memcpy in this case, every column has to be
+        // processed separately.
+        for (uint32_t r = 0; r < numRows; r++) {
           for (uint32_t i = 0; i < numProps; i++) {
             uint32_t propIdx = propIdxs[i];
             const PLYProperty& prop = elem->properties[propIdx];
-            std::memcpy(to, row + prop.offset, colBytes);
+            copy_and_convert(to, destType, row + prop.offset, prop.type);
             to += colBytes;
           }
-          row += elem->rowStride;
+          row += srcStride;
         }
       }
-    }
-    else {
-      // We will have to do data type conversions on the column values here. We
-      // cannot simply use memcpy in this case, every column has to be
-      // processed separately.
-      const uint8_t* row = m_elementData.data();
-      const uint8_t* end = m_elementData.data() + m_elementData.size();
-      uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-      size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
-      while (row < end) {
-        for (uint32_t i = 0; i < numProps; i++) {
-          uint32_t propIdx = propIdxs[i];
-          const PLYProperty& prop = elem->properties[propIdx];
-          copy_and_convert(to, destType, row + prop.offset, prop.type);
-          to += colBytes;
-        }
-        row += elem->rowStride;
-      }
-    }
+    });
 
     return true;
   }
@@ -1054,62 +1193,56 @@ namespace miniply {
       }
     }
 
-    uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-    if (!conversionRequired) {
-      // If no data conversion is required, we can just use memcpy to get
-      // values into dest. When the destination requires some padding between
-      // rows, the best we can do is a memcpy per row.
-      if (contiguousCols) {
-        // If the rows aren't contiguous, but the columns we're extracting
-        // within each row are, then we can do a single memcpy per row.
-        const uint8_t* from = m_elementData.data() + elem->properties[propIdxs[0]].offset;
-        const uint8_t* end = m_elementData.data() + m_elementData.size();
-        const size_t numBytes = expectedOffset - elem->properties[propIdxs[0]].offset;
-        while (from < end) {
-          std::memcpy(to, from, numBytes);
-          from += elem->rowStride;
-          to += destStride;
+    const uint8_t* data = element_data();
+    const size_t srcStride = elem->rowStride;
+    const size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
+    const size_t colPadding = destStride - minDestStride;
+
+    // Rows are independent, so large elements are extracted in parallel slices.
+    for_each_row_slice(elem->count, [&](uint32_t firstRow, uint32_t endRow) {
+      const uint8_t* row = data + firstRow * srcStride;
+      uint8_t* to = reinterpret_cast<uint8_t*>(dest) + size_t(firstRow) * destStride;
+      const uint32_t numRows = endRow - firstRow;
+      if (!conversionRequired) {
+        // If no data conversion is required, we can just use memcpy to get
+        // values into dest. When the destination requires some padding between
+        // rows, the best we can do is a memcpy per row.
+        if (contiguousCols) {
+          // If the rows aren't contiguous, but the columns we're extracting
+          // within each row are, then we can do a single memcpy per row.
+          const uint32_t firstOffset = elem->properties[propIdxs[0]].offset;
+          copy_rows(to, destStride, row + firstOffset, srcStride, expectedOffset - firstOffset, numRows);
+        }
+        else {
+          // If the columns aren't contiguous, we must memcpy each one separately.
+          for (uint32_t r = 0; r < numRows; r++) {
+            for (uint32_t i = 0; i < numProps; i++) {
+              uint32_t propIdx = propIdxs[i];
+              const PLYProperty& prop = elem->properties[propIdx];
+              std::memcpy(to, row + prop.offset, colBytes);
+              to += colBytes;
+            }
+            row += srcStride;
+            to += colPadding;
+          }
         }
       }
       else {
-        // If the columns aren't contiguous, we must memcpy each one separately.
-        const uint8_t* row = m_elementData.data();
-        const uint8_t* end = m_elementData.data() + m_elementData.size();
-        uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-        const size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
-        const size_t colPadding = destStride - minDestStride;
-        while (row < end) {
+        // We will have to do data type conversions on the column values here. We
+        // cannot simply use memcpy in this case, every column has to be
+        // processed separately.
+        for (uint32_t r = 0; r < numRows; r++) {
           for (uint32_t i = 0; i < numProps; i++) {
             uint32_t propIdx = propIdxs[i];
             const PLYProperty& prop = elem->properties[propIdx];
-            std::memcpy(to, row + prop.offset, colBytes);
+            copy_and_convert(to, destType, row + prop.offset, prop.type);
             to += colBytes;
           }
-          row += elem->rowStride;
+          row += srcStride;
           to += colPadding;
         }
       }
-    }
-    else {
-      // We will have to do data type conversions on the column values here. We
-      // cannot simply use memcpy in this case, every column has to be
-      // processed separately.
-      const uint8_t* row = m_elementData.data();
-      const uint8_t* end = m_elementData.data() + m_elementData.size();
-      uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-      size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
-      size_t colPadding = destStride - minDestStride;
-      while (row < end) {
-        for (uint32_t i = 0; i < numProps; i++) {
-          uint32_t propIdx = propIdxs[i];
-          const PLYProperty& prop = elem->properties[propIdx];
-          copy_and_convert(to, destType, row + prop.offset, prop.type);
-          to += colBytes;
-        }
-        row += elem->rowStride;
-        to += colPadding;
-      }
-    }
+    });
 
     return true;
   }
@@ -1610,6 +1743,18 @@ namespace miniply {
   {
     size_t numBytes = static_cast<size_t>(elem.count) * elem.rowStride;
 
+    // Large little-endian elements need no conversion at all, so we read them
+    // straight from a memory mapping of the file instead of copying them.
+    if (m_fileType == PLYFileType::Binary && numBytes >= kPLYMinMappedElementSize) {
+      if (map_element(numBytes)) {
+        m_elementLoaded = true;
+        return true;
+      }
+      if (!m_valid) {
+        return false;
+      }
+    }
+
     m_elementData.resize(numBytes);
 
     if (m_fileType == PLYFileType::ASCII) {
@@ -1677,6 +1822,50 @@ namespace miniply {
   }
 
 
+  bool PLYReader::map_element(size_t numBytes)
+  {
+    if (m_mapData == nullptr && !file_map(m_f, &m_mapData, &m_mapSize, &m_mapHandle)) {
+      // Fall back to reading through the buffer.
+      m_mapData = nullptr;
+      m_mapSize = 0;
+      return false;
+    }
+
+    // The file position corresponds to the end of the last fread. Unless we hit
+    // the end of the file that was a full buffer, `m_bufEnd` may have been moved
+    // back by `rewind_to_safe_char` while parsing the header.
+    const char* readEnd = m_atEOF ? m_bufEnd : m_buf + kPLYReadBufferSize;
+    int64_t elementStart = file_tell(m_f) - static_cast<int64_t>(readEnd - m_pos);
+    if (elementStart < 0 || static_cast<size_t>(elementStart) + numBytes > m_mapSize) {
+      m_valid = false;
+      return false;
+    }
+    m_elementView = m_mapData + elementStart;
+
+    // Move the read buffer past the element, so the next one can be parsed
+    // as usual.
+    if (m_pos + numBytes <= m_bufEnd) {
+      m_pos += numBytes;
+      m_end = m_pos;
+    }
+    else {
+      m_bufOffset = elementStart + static_cast<int64_t>(numBytes);
+      file_seek(m_f, m_bufOffset, SEEK_SET);
+      m_bufEnd = m_buf + kPLYReadBufferSize;
+      m_pos = m_bufEnd;
+      m_end = m_bufEnd;
+      refill_buffer();
+    }
+    return true;
+  }
+
+
+  const uint8_t* PLYReader::element_data() const
+  {
+    return (m_elementView != nullptr) ? m_elementView : m_elementData.data();
+  }
+
+
   bool PLYReader::load_variable_size_element(PLYElement& elem)
   {
     m_elementData.resize(static_cast<size_t>(elem.count) * elem.rowStride);
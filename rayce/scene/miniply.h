@@ -261,6 +261,8 @@ namespace miniply {
     bool parse_property(std::vector<PLYProperty>& properties);
 
     bool load_fixed_size_element(PLYElement& elem);
+    bool map_element(size_t numBytes);
+    const uint8_t* element_data() const;
     bool load_variable_size_element(PLYElement& elem);
 
     bool load_ascii_scalar_property(PLYProperty& prop, size_t& destIndex);
@@ -293,6 +295,13 @@ namespace miniply {
     bool m_elementLoaded    = false;
     std::vector<uint8_t> m_elementData;
 
+    // Large fixed size little-endian elements are read directly from a
+    // memory mapping of the file instead of `m_elementData`.
+    const uint8_t* m_mapData     = nullptr;
+    size_t m_mapSize             = 0;
+    void* m_mapHandle            = nullptr;
+    const uint8_t* m_elementView = nullptr;
+
     char* m_tmpBuf = nullptr;
   };
 
@@ -4,12 +4,24 @@
 /// @date      2024
 /// @copyright Apache License 2.0
 
+#include <atomic>
 #include <cctype>
+#include <deque>
 #include <filesystem>
+#include <fstream>
 #include <functional>
 #include <hostDeviceInterop.slang>
 #include <imgui.h>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <core/mappedFile.hpp>
+#include <core/parallel.hpp>
+#include <core/timer.hpp>
+#include <scene/compiledScene.hpp>
 #include <scene/loadHelper.hpp>
+#include <scene/meshCache.hpp>
+#include <scene/meshLoader.hpp>
 #include <scene/rayceScene.hpp>
 #include <vulkan/buffer.hpp>
 #include <vulkan/commandPool.hpp>
@@ -19,9 +31,6 @@
 #include <vulkan/imageView.hpp>
 #include <vulkan/sampler.hpp>
 
-#include <scene/miniply.h>
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
 #include <scene/tinyparser-mitsuba.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -53,10 +62,85 @@ struct MitsubaShape
 {
     EShapeType type;
     str filename;
+    // index of the mesh inside a serialized file
+    uint32 shapeIndex{ 0 };
     mat4 transformationMatrix;
     bool faceNormals;
     MitsubaRef bsdf;
     int32 emitter{ -1 };
+    // shapes of a shape group are only placed by the instances referencing the group
+    bool instanced{ false };
+    std::vector<mat4> instanceTransformations;
+};
+
+// small meshes baked into one geometry, the materials are stored per triangle
+struct MergedMesh
+{
+    MeshData mesh;
+    std::vector<uint32> triangleMaterialIds;
+    uint32 shapeCount{ 0 };
+};
+
+struct TextureRequest
+{
+    str name;
+    str filename;
+    bool srgb{ true };
+    uint64 contentHash{ 0 };
+    ptr_size contentSize{ 0 };
+    int32 width{ 0 };
+    int32 height{ 0 };
+    byte* pixels{ nullptr };
+    double decodeMilliseconds{ 0.0 };
+};
+
+/// @brief The state of a running Mitsuba scene load shared by the loading threads and the integration on the main thread.
+struct rayce::SceneLoadState
+{
+    ~SceneLoadState()
+    {
+        for (TextureRequest& texture : textures)
+        {
+            // decoded but never handed over to the image cache
+            stbi_image_free(texture.pixels);
+        }
+    }
+
+    SceneLoadOptions options;
+    std::vector<MitsubaShape> shapes;
+    std::vector<MitsubaEmitter> emitters;
+    std::map<str, MitsubaBSDF> bsdfs;
+    std::vector<TextureRequest> textures;
+
+    // the shapes loading a mesh file and, per loading shape, all shapes sharing its mesh
+    std::vector<ptr_size> meshSources;
+    std::vector<std::vector<ptr_size>> meshInstances;
+    std::vector<MeshData> meshes;
+    // per loading shape, the chunks of a mesh split for SceneLoadOptions::meshChunkTriangles, empty if not split
+    std::vector<std::vector<MeshData>> meshChunks;
+    std::vector<byte> meshLoaded;
+    std::vector<double> meshLoadMilliseconds;
+
+    // the merged mesh collecting small meshes and the flushed ones, a deque keeps the compiled scene spans valid
+    MergedMesh pendingMerge;
+    std::deque<MergedMesh> mergedMeshes;
+
+    AxisAlignedBoundingBox sceneBounds;
+    bool spheresAdded{ false };
+    Timer loadTimer;
+
+    // the compiled scene references the loaded data, so meshes are only released after it is written
+    bool compile{ false };
+    CompiledScene compiledScene;
+
+    // finished jobs are handed over to the main thread, only these lists are shared
+    std::mutex mutex;
+    std::vector<ptr_size> readyMeshes;
+    std::vector<ptr_size> readyTextures;
+    ptr_size remainingMeshes{ 0 };
+    ptr_size remainingTextures{ 0 };
+    std::atomic<bool> cancel{ false };
+    std::thread worker;
 };
 
 RayceScene::RayceScene()
@@ -66,9 +150,11 @@ RayceScene::RayceScene()
 
 RayceScene::~RayceScene()
 {
+    cancelSceneLoad();
+
     for (auto& cached : mImageCache)
     {
-        delete[] cached.second;
+        stbi_image_free(cached.second);
     }
     mImageCache.clear();
 }
@@ -299,7 +385,19 @@ static ComplexIOR complexIORData[] = {
     { "Mo_palik" }
 };
 
-static std::tuple<vec3, vec3> conductorComplexIorFromString(str materialName)
+static double elapsedMilliseconds(const Timer& timer)
+{
+    return static_cast<double>(timer.elapsedMicroseconds().count()) * 0.001;
+}
+
+static uint64 fileSize(const str& filename)
+{
+    std::error_code error;
+    uint64 size = static_cast<uint64>(fs::file_size(filename, error));
+    return error ? 0 : size;
+}
+
+static std::tuple<vec3, vec3> conductorComplexIorFromString(str materialName, SceneLoadPhaseTiming& spectrumReads)
 {
     if (materialName == "none")
     {
@@ -312,8 +410,19 @@ static std::tuple<vec3, vec3> conductorComplexIorFromString(str materialName)
     {
         if (materialName == ior->name)
         {
-            vec3 rgbEta = spectrumToRGB(LinearInterpolatedSpectrum::fromFile(str("assets/spectra/") + materialName + str(".eta.spd")));
-            vec3 rgbK   = spectrumToRGB(LinearInterpolatedSpectrum::fromFile(str("assets/spectra/") + materialName + str(".k.spd")));
+            Timer timer;
+            timer.start();
+
+            // the spectra and their rgb projections are cached, every file is only read for the first material using it
+            str etaFile = str("assets/spectra/") + materialName + str(".eta.spd");
+            str kFile   = str("assets/spectra/") + materialName + str(".k.spd");
+            bool etaRead, kRead;
+            vec3 rgbEta = Spectra::getFileSpectrum(etaFile, etaRead).rgb;
+            vec3 rgbK   = Spectra::getFileSpectrum(kFile, kRead).rgb;
+
+            spectrumReads.milliseconds += elapsedMilliseconds(timer);
+            spectrumReads.bytes += (etaRead ? fileSize(etaFile) : 0) + (kRead ? fileSize(kFile) : 0);
+            spectrumReads.count += (etaRead ? 1 : 0) + (kRead ? 1 : 0);
 
             return { rgbEta, rgbK };
         }
@@ -346,7 +455,7 @@ static LinearInterpolatedSpectrum convertMitsubaSpectrumToLIS(const mp::Spectrum
     return spectrum;
 }
 
-static MitsubaBSDF loadMitsubaBSDF(const std::shared_ptr<mp::Object>& bsdfObject, std::vector<str>& imagesToLoad, bool twoSided = false)
+static MitsubaBSDF loadMitsubaBSDF(const std::shared_ptr<mp::Object>& bsdfObject, std::vector<str>& imagesToLoad, SceneLoadPhaseTiming& spectrumReads, bool twoSided = false)
 {
     MitsubaBSDF bsdf;
     const str pluginType       = bsdfObject->pluginType();
@@ -503,7 +612,7 @@ static MitsubaBSDF loadMitsubaBSDF(const std::shared_ptr<mp::Object>& bsdfObject
                 continue;
             }
 
-            auto inlineBSDF = loadMitsubaBSDF(bsdfChild, imagesToLoad, true);
+            auto inlineBSDF = loadMitsubaBSDF(bsdfChild, imagesToLoad, spectrumReads, true);
 
             if (inlineBSDF.id.empty())
             {
@@ -521,7 +630,7 @@ static MitsubaBSDF loadMitsubaBSDF(const std::shared_ptr<mp::Object>& bsdfObject
                 continue;
             }
 
-            auto inlineBSDF = loadMitsubaBSDF(bsdfChild, imagesToLoad, true);
+            auto inlineBSDF = loadMitsubaBSDF(bsdfChild, imagesToLoad, spectrumReads, true);
 
             if (inlineBSDF.id.empty())
             {
@@ -781,7 +890,7 @@ static MitsubaBSDF loadMitsubaBSDF(const std::shared_ptr<mp::Object>& bsdfObject
 
             if (material.type() == mp::PT_STRING) // <string></string>
             {
-                auto complexIor                = conductorComplexIorFromString(material.getString());
+                auto complexIor                = conductorComplexIorFromString(material.getString(), spectrumReads);
                 bsdf.possibleData.conductorEta = std::get<0>(complexIor);
                 bsdf.possibleData.conductorK   = std::get<1>(complexIor);
             }
@@ -1223,135 +1332,532 @@ static MitsubaEmitter loadMitsubaEmitter(const std::shared_ptr<mp::Object>& emit
     return emitter;
 }
 
-void RayceScene::loadFromMitsubaFile(const str& filename, const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, float scale)
+static str resolveTexturePath(const str& imageFile, const str& sceneFilename)
+{
+    str resolvedFile = imageFile;
+    if (!fs::exists(resolvedFile))
+    {
+        resolvedFile = fs::path(sceneFilename).parent_path().concat("/" + imageFile).string();
+        if (!fs::exists(resolvedFile))
+        {
+            RAYCE_LOG_ERROR("Can not find %s nor %s", imageFile.c_str(), resolvedFile.c_str());
+            return imageFile;
+        }
+    }
+
+    std::error_code error;
+    str canonicalFile = fs::weakly_canonical(resolvedFile, error).generic_string();
+    return error ? resolvedFile : canonicalFile;
+}
+
+static void decodeTexture(TextureRequest& texture)
+{
+    int32 c;
+    texture.pixels = stbi_load(texture.filename.c_str(), &texture.width, &texture.height, &c, STBI_rgb_alpha);
+    if (!texture.pixels)
+    {
+        RAYCE_LOG_ERROR("Can not load: %s", texture.filename.c_str());
+        return;
+    }
+    RAYCE_LOG_INFO("Loaded %s as %s", texture.filename.c_str(), texture.name.c_str());
+}
+
+static mat4 transformFromProperties(const mp::Object& object)
+{
+    mat4 transformationMatrix = mat4::Identity();
+    for (const auto& prop : object.properties())
+    {
+        if (prop.first == "to_world")
+        {
+            const auto& transform = prop.second.getTransform();
+            for (int i = 0; i < 4; i++)
+            {
+                for (int j = 0; j < 4; j++)
+                {
+                    transformationMatrix(i, j) = transform(i, j);
+                }
+            }
+        }
+    }
+    return transformationMatrix;
+}
+
+static std::span<const mat4> shapeTransformations(const MitsubaShape& shape)
+{
+    return shape.instanced ? std::span<const mat4>(shape.instanceTransformations) : std::span<const mat4>(&shape.transformationMatrix, 1);
+}
+
+static bool isTriangleMesh(const MitsubaShape& shape)
+{
+    return shape.type == EShapeType::triangleMesh || shape.type == EShapeType::rectangle || shape.type == EShapeType::cube;
+}
+
+// merged meshes are flushed into a geometry of their own once they hold this many triangles
+static constexpr ptr_size kMergedMeshTriangleBudget = 1 << 20;
+
+// mesh cache variant bits of meshes with reordered triangles and of cleaned up meshes
+static constexpr uint32 kOptimizedMeshVariant = 1u << 31;
+static constexpr uint32 kCleanedMeshVariant   = 1u << 30;
+
+// the options changing the loaded data, a compiled scene is only valid for the options it was written with
+static uint64 hashCompiledSceneOptions(const SceneLoadOptions& options)
+{
+    const uint32 values[] = { options.shareMeshes ? 1u : 0u, options.hashTextureContent ? 1u : 0u, options.cleanupMeshes ? 1u : 0u, options.optimizeTriangleOrder ? 1u : 0u,
+                              options.meshChunkTriangles, options.mergeTriangleLimit };
+    return hashBytes(values, sizeof(values));
+}
+
+static bool loadShapeMesh(const MitsubaShape& shape, const SceneLoadOptions& options, MeshData& mesh)
+{
+    str ext = shape.filename.substr(shape.filename.find_last_of(".") + 1);
+
+    // obj corners are welded, so shapes that need face normals (like cubes) keep them without an extra variant
+    // serialized files hold several meshes, the shape index keeps their cache entries apart
+    // reordered and cleaned up meshes are cached separately from meshes as stored in the file
+    const bool cleanup   = options.cleanupMeshes && (ext == "ply" || ext == "obj");
+    const uint32 variant = (ext == "serialized" ? shape.shapeIndex : 0) | (options.optimizeTriangleOrder ? kOptimizedMeshVariant : 0) | (cleanup ? kCleanedMeshVariant : 0);
+
+    if (options.useMeshCache && loadCachedMesh(options.meshCacheDirectory, shape.filename, variant, mesh))
+    {
+        return true;
+    }
+
+    bool loaded = false;
+    if (ext == "ply")
+    {
+        loaded = loadPlyMesh(shape.filename, mesh);
+    }
+    if (ext == "obj")
+    {
+        loaded = loadObjMesh(shape.filename, mesh);
+    }
+    if (ext == "serialized")
+    {
+        loaded = loadSerializedMesh(shape.filename, shape.shapeIndex, mesh);
+    }
+
+    if (!loaded)
+    {
+        return false;
+    }
+
+    // malformed files can reference vertices they do not have, every later step indexes the vertices blindly
+    const std::span<const Vertex> vertices = mesh.getVertices();
+    const std::span<const uint32> indices  = mesh.getIndices();
+    if (std::any_of(indices.begin(), indices.end(), [&vertices](uint32 index) { return index >= vertices.size(); }))
+    {
+        RAYCE_LOG_ERROR("%s references vertices it does not have, skipping it!", shape.filename.c_str());
+        return false;
+    }
+
+    if (cleanup)
+    {
+        cleanupMesh(mesh);
+    }
+
+    // a mesh without any (non degenerate) triangle has no geometry to upload
+    if (mesh.getIndices().size() < 3)
+    {
+        RAYCE_LOG_WARN("%s has no triangles left, skipping it!", shape.filename.c_str());
+        return false;
+    }
+
+    if (options.optimizeTriangleOrder)
+    {
+        optimizeTriangleOrder(mesh);
+    }
+
+    if (options.useMeshCache)
+    {
+        storeCachedMesh(options.meshCacheDirectory, shape.filename, variant, mesh);
+    }
+
+    return true;
+}
+
+static void runSceneLoadJobs(SceneLoadState& state)
+{
+    // parsing, vertex preprocessing and decoding run on worker threads, everything touching vulkan or the geometry
+    // is done by the main thread when it picks up the finished jobs
+    parallelFor(
+        state.meshSources.size(),
+        [&state](ptr_size m)
+        {
+            if (state.cancel)
+            {
+                return;
+            }
+
+            Timer timer;
+            timer.start();
+
+            const ptr_size s              = state.meshSources[m];
+            state.meshLoaded[s]           = loadShapeMesh(state.shapes[s], state.options, state.meshes[s]) ? 1 : 0;
+            const uint32 chunkTriangles   = state.options.meshChunkTriangles;
+            if (state.meshLoaded[s] && chunkTriangles > 0 && state.meshes[s].getIndices().size() / 3 > chunkTriangles)
+            {
+                splitMeshChunks(state.meshes[s], chunkTriangles, state.meshChunks[s]);
+            }
+            state.meshLoadMilliseconds[s] = elapsedMilliseconds(timer);
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.readyMeshes.push_back(s);
+        },
+        state.options.parallelMeshLoading ? 0 : 1);
+
+    parallelFor(
+        state.textures.size(),
+        [&state](ptr_size t)
+        {
+            if (state.cancel)
+            {
+                return;
+            }
+
+            Timer timer;
+            timer.start();
+
+            decodeTexture(state.textures[t]);
+            state.textures[t].decodeMilliseconds = elapsedMilliseconds(timer);
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.readyTextures.push_back(t);
+        },
+        state.options.parallelTextureDecoding ? 0 : 1);
+}
+
+static void uploadTexture(const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, const byte* pixels, uint32 width, uint32 height, uint32 components, bool srgb,
+                          std::unique_ptr<Image>& image, std::unique_ptr<ImageView>& imageView, std::unique_ptr<Sampler>& sampler)
+{
+    uint32 imageSize = width * height * components;
+    VkFormat format  = getImageFormat(components, srgb);
+
+    VkExtent2D extent{ width, height };
+    image = std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    image->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    image->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    VkExtent3D extent3D{ width, height, 1 };
+    Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *image, pixels, imageSize, extent3D);
+    image->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    imageView = std::make_unique<ImageView>(logicalDevice, *image, format, VK_IMAGE_ASPECT_COLOR_BIT);
+    sampler   = std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
+                                          VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS); // default sampler
+}
+
+template <typename T>
+static std::unique_ptr<Buffer> createInputBuffer(const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, const T* data, ptr_size count, VkBufferUsageFlags usage)
+{
+    std::unique_ptr<Buffer> buffer = std::make_unique<Buffer>(logicalDevice, sizeof(T) * count,
+                                                              usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    buffer->allocateMemory(logicalDevice, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    Buffer::uploadDataWithStagingBuffer(logicalDevice, commandPool, *buffer, data, count);
+    return buffer;
+}
+
+static VkDeviceSize createMeshBuffers(const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, std::span<const Vertex> vertices, std::span<const uint32> indices,
+                                      bool withAttributes, bool shortIndices, bool compactAttributes, std::unique_ptr<Buffer>& positionBuffer, std::unique_ptr<Buffer>& attributeBuffer, std::unique_ptr<Buffer>& indexBuffer,
+                                      VkIndexType& indexType)
+{
+    // the BLAS only reads the tightly packed positions, normals and uvs go to a separate stream for shading
+    std::vector<vec3> positions;
+    std::vector<VertexAttributes> attributes;
+    std::vector<CompactVertexAttributes> packedAttributes;
+    splitVertexStreams(vertices, withAttributes, compactAttributes, positions, attributes, packedAttributes);
+
+    const VkBufferUsageFlags inputUsage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+    positionBuffer                      = createInputBuffer(logicalDevice, commandPool, positions.data(), positions.size(), inputUsage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    VkDeviceSize uploadBytes            = positions.size() * sizeof(vec3);
+
+    attributeBuffer.reset();
+    if (!attributes.empty())
+    {
+        attributeBuffer = createInputBuffer(logicalDevice, commandPool, attributes.data(), attributes.size(), 0);
+        uploadBytes += attributes.size() * sizeof(VertexAttributes);
+    }
+    if (!packedAttributes.empty())
+    {
+        attributeBuffer = createInputBuffer(logicalDevice, commandPool, packedAttributes.data(), packedAttributes.size(), 0);
+        uploadBytes += packedAttributes.size() * sizeof(CompactVertexAttributes);
+    }
+
+    // meshes addressable with 16 bit indices are narrowed on upload, mesh cache and compiled scenes keep 32 bit indices
+    indexType = VK_INDEX_TYPE_UINT32;
+    if (shortIndices && vertices.size() <= std::numeric_limits<uint16>::max() + 1)
+    {
+        indexType = VK_INDEX_TYPE_UINT16;
+        // the shaders read the buffer as packed 32 bit words, so the count is padded to an even number
+        std::vector<uint16> narrowIndices(indices.size() + (indices.size() & 1), 0);
+        std::transform(indices.begin(), indices.end(), narrowIndices.begin(), [](uint32 index) { return static_cast<uint16>(index); });
+        indexBuffer = createInputBuffer(logicalDevice, commandPool, narrowIndices.data(), narrowIndices.size(), inputUsage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        return uploadBytes + narrowIndices.size() * sizeof(uint16);
+    }
+
+    // mapped data (mesh cache, compiled scenes) is copied straight into the staging buffer
+    indexBuffer = createInputBuffer(logicalDevice, commandPool, indices.data(), indices.size(), inputUsage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    return uploadBytes + indices.size_bytes();
+}
+
+void RayceScene::loadFromMitsubaFile(const str& filename, const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, float scale, const SceneLoadOptions& options)
 {
+    // everything the worker threads and the later integration steps need lives in the load state
+    cancelSceneLoad();
+    pLoadState            = std::make_unique<SceneLoadState>();
+    SceneLoadState& state = *pLoadState;
+    state.options         = options;
+    state.loadTimer.start();
+
+    if (state.options.meshCacheDirectory.empty())
+    {
+        state.options.meshCacheDirectory = defaultMeshCacheDirectory();
+    }
+
+    mReflectionInfo.loadMilliseconds = 0.0;
+    mReflectionInfo.loadPhases       = {};
+    mReflectionInfo.meshLoadTimings.clear();
+    mReflectionInfo.textureLoadTimings.clear();
+
+    Timer phaseTimer;
+    phaseTimer.start();
+
     mp::SceneLoader sceneLoader;
 
     mp::Scene scene = sceneLoader.loadFromFile(filename.c_str());
 
+    addLoadTiming(ESceneLoadPhase::xmlParse, elapsedMilliseconds(phaseTimer), fileSize(filename));
+
     RAYCE_LOG_INFO("Loading Mitsuba file %s.", filename.c_str());
-    // FIXME: Implement more features - sensor, instances, shapegroups, primitives not loaded from files etc.
+    // FIXME: Implement more features - sensor, primitives not loaded from files etc.
 
     mReflectionInfo.filename = filename;
 
-    std::vector<MitsubaShape> mitsubaShapes;
-    std::vector<MitsubaEmitter> mitsubaEmitters;
-    std::map<str, MitsubaBSDF> mitsubaBSDFs;
+    // spectrum files are read while converting bsdfs, their time is reported separately
+    phaseTimer.restart();
+    SceneLoadPhaseTiming& spectrumReads = mReflectionInfo.loadPhases[static_cast<ptr_size>(ESceneLoadPhase::spectrumReads)];
+    if (options.preloadSpectra)
+    {
+        // the cache is process wide, only the first load reads the files
+        Timer timer;
+        timer.start();
+        spectrumReads.count += Spectra::preloadFileSpectra("assets/spectra");
+        spectrumReads.milliseconds += elapsedMilliseconds(timer);
+    }
+
+    std::vector<MitsubaShape>& mitsubaShapes     = state.shapes;
+    std::vector<MitsubaEmitter>& mitsubaEmitters = state.emitters;
+    std::map<str, MitsubaBSDF>& mitsubaBSDFs     = state.bsdfs;
     std::vector<str> imagesToLoad;
     uint32 inlineBSDFId = 0;
 
-    auto loadTopLevelObject = [&](const std::shared_ptr<mp::Object>& object)
+    auto loadShape = [&](const std::shared_ptr<mp::Object>& object, bool instanced)
     {
-        switch (object->type())
+        MitsubaShape shape;
+        auto pluginType = object->pluginType();
+        mReflectionInfo.meshNames.push_back(object->id());
+        mReflectionInfo.meshTriCounts.push_back(0);
+        mReflectionInfo.meshSourceTriCounts.push_back(0);
+        mReflectionInfo.meshVertexCounts.push_back(0);
+        mReflectionInfo.meshSourceVertexCounts.push_back(0);
+        mReflectionInfo.meshCacheMissesBefore.push_back(0.0f);
+        mReflectionInfo.meshCacheMissesAfter.push_back(0.0f);
+        if (pluginType == "sphere")
         {
-        case mp::OT_SHAPE:
+            shape.type = EShapeType::sphere;
+        }
+        if (pluginType == "rectangle")
         {
-            MitsubaShape shape;
-            auto pluginType = object->pluginType();
-            mReflectionInfo.meshNames.push_back(object->id());
-            mReflectionInfo.meshTriCounts.push_back(0);
-            if (pluginType == "sphere")
-            {
-                shape.type = EShapeType::sphere;
-            }
-            if (pluginType == "rectangle")
+            shape.type     = EShapeType::rectangle;
+            shape.filename = "assets/internal/rectangle.ply";
+        }
+        if (pluginType == "cube")
+        {
+            shape.type     = EShapeType::cube;
+            shape.filename = "assets/internal/cube.obj";
+        }
+
+        shape.transformationMatrix = mat4::Identity();
+        for (const auto& prop : object->properties())
+        {
+            if (pluginType == "ply" && prop.first == "filename")
             {
-                shape.type     = EShapeType::rectangle;
-                shape.filename = "assets/internal/rectangle.ply";
+                shape.type     = EShapeType::triangleMesh;
+                shape.filename = fs::path(filename).parent_path().concat("/" + prop.second.getString()).string();
             }
-            if (pluginType == "cube")
+            if (pluginType == "obj" && prop.first == "filename")
             {
-                shape.type     = EShapeType::cube;
-                shape.filename = "assets/internal/cube.obj";
+                shape.type     = EShapeType::triangleMesh;
+                shape.filename = fs::path(filename).parent_path().concat("/" + prop.second.getString()).string();
             }
-
-            shape.transformationMatrix = mat4::Identity();
-            for (const auto& prop : object->properties())
+            if (pluginType == "serialized")
             {
-                if (pluginType == "ply" && prop.first == "filename")
-                {
-                    shape.type     = EShapeType::triangleMesh;
-                    shape.filename = fs::path(filename).parent_path().concat("/" + prop.second.getString()).string();
-                }
-                if (pluginType == "obj" && prop.first == "filename")
+                if (prop.first == "filename")
                 {
                     shape.type     = EShapeType::triangleMesh;
                     shape.filename = fs::path(filename).parent_path().concat("/" + prop.second.getString()).string();
                 }
-
-                if (pluginType == "sphere")
+                if (prop.first == "shape_index")
                 {
-                    if (prop.first == "center")
-                    {
-                        const auto& sCenter                          = prop.second.getVector();
-                        shape.transformationMatrix.block<3, 1>(0, 3) = vec3(sCenter.x, sCenter.y, sCenter.z);
-                        RAYCE_LOG_INFO("------------------------- %f, %f, %f", sCenter.x, sCenter.y, sCenter.z);
-                    }
-                    if (prop.first == "radius")
-                    {
-                        const auto& sRadius                                     = prop.second.getNumber();
-                        shape.transformationMatrix.block<3, 3>(0, 0).diagonal() = vec3(sRadius, sRadius, sRadius);
-                    }
+                    shape.shapeIndex = static_cast<uint32>(prop.second.getInteger());
                 }
+            }
 
-                if (prop.first == "to_world")
+            if (pluginType == "sphere")
+            {
+                if (prop.first == "center")
                 {
-                    const auto& transform = prop.second.getTransform();
-                    for (int i = 0; i < 4; i++)
-                    {
-                        for (int j = 0; j < 4; j++)
-                        {
-                            shape.transformationMatrix(i, j) = transform(i, j);
-                        }
-                    }
+                    const auto& sCenter                          = prop.second.getVector();
+                    shape.transformationMatrix.block<3, 1>(0, 3) = vec3(sCenter.x, sCenter.y, sCenter.z);
+                    RAYCE_LOG_INFO("------------------------- %f, %f, %f", sCenter.x, sCenter.y, sCenter.z);
                 }
-
-                if (prop.first == "face_normals")
+                if (prop.first == "radius")
                 {
-                    shape.faceNormals = prop.second.getBool();
+                    const auto& sRadius                                     = prop.second.getNumber();
+                    shape.transformationMatrix.block<3, 3>(0, 0).diagonal() = vec3(sRadius, sRadius, sRadius);
                 }
             }
 
-            auto loadShapeChild = [&](const std::shared_ptr<mp::Object>& child)
+            if (prop.first == "to_world")
             {
-                if (child->type() == mp::OT_BSDF)
+                const auto& transform = prop.second.getTransform();
+                for (int i = 0; i < 4; i++)
                 {
-                    if (mitsubaBSDFs.find(child->id()) != mitsubaBSDFs.end())
+                    for (int j = 0; j < 4; j++)
                     {
-                        shape.bsdf = child->id();
-                        return;
+                        shape.transformationMatrix(i, j) = transform(i, j);
                     }
-                    MitsubaBSDF mbsdf = loadMitsubaBSDF(child, imagesToLoad);
+                }
+            }
 
-                    if (mbsdf.id.empty())
-                    {
-                        mbsdf.id = "inline_bsdf_" + std::to_string(inlineBSDFId++); // FIXME: potential collisions
-                    }
+            if (prop.first == "face_normals")
+            {
+                shape.faceNormals = prop.second.getBool();
+            }
+        }
 
-                    shape.bsdf               = mbsdf.id;
-                    mitsubaBSDFs[shape.bsdf] = mbsdf;
+        auto loadShapeChild = [&](const std::shared_ptr<mp::Object>& child)
+        {
+            if (child->type() == mp::OT_BSDF)
+            {
+                if (mitsubaBSDFs.find(child->id()) != mitsubaBSDFs.end())
+                {
+                    shape.bsdf = child->id();
                     return;
                 }
+                MitsubaBSDF mbsdf = loadMitsubaBSDF(child, imagesToLoad, spectrumReads);
+
+                if (mbsdf.id.empty())
+                {
+                    mbsdf.id = "inline_bsdf_" + std::to_string(inlineBSDFId++); // FIXME: potential collisions
+                }
 
-                if (child->type() == mp::OT_EMITTER)
+                shape.bsdf               = mbsdf.id;
+                mitsubaBSDFs[shape.bsdf] = mbsdf;
+                return;
+            }
+
+            if (child->type() == mp::OT_EMITTER)
+            {
+                if (instanced)
                 {
-                    MitsubaEmitter emitter = loadMitsubaEmitter(child, imagesToLoad);
-                    shape.emitter          = mitsubaEmitters.size();
-                    mitsubaEmitters.push_back(emitter);
+                    RAYCE_LOG_WARN("Emitters in shape groups are not supported, ignoring the emitter of %s!", object->id().c_str());
                     return;
                 }
-            };
 
-            for (const auto& child : object->anonymousChildren())
+                MitsubaEmitter emitter = loadMitsubaEmitter(child, imagesToLoad);
+                shape.emitter          = mitsubaEmitters.size();
+                mitsubaEmitters.push_back(emitter);
+                return;
+            }
+        };
+
+        for (const auto& child : object->anonymousChildren())
+        {
+            loadShapeChild(child);
+        }
+        for (const auto& [childName, child] : object->namedChildren())
+        {
+            (void)childName;
+            loadShapeChild(child);
+        }
+        shape.instanced = instanced;
+        mitsubaShapes.push_back(shape);
+        return mitsubaShapes.size() - 1;
+    };
+
+    // every shape group is converted once, its shapes are only placed by instances
+    std::unordered_map<const mp::Object*, std::vector<ptr_size>> shapeGroups;
+    auto loadShapeGroup = [&](const std::shared_ptr<mp::Object>& group) -> const std::vector<ptr_size>&
+    {
+        auto it = shapeGroups.find(group.get());
+        if (it != shapeGroups.end())
+        {
+            return it->second;
+        }
+
+        std::vector<ptr_size> groupShapes;
+        for (const auto& child : group->anonymousChildren())
+        {
+            if (child->type() == mp::OT_SHAPE)
+            {
+                groupShapes.push_back(loadShape(child, true));
+            }
+        }
+        for (const auto& [childName, child] : group->namedChildren())
+        {
+            (void)childName;
+            if (child->type() == mp::OT_SHAPE)
+            {
+                groupShapes.push_back(loadShape(child, true));
+            }
+        }
+        return shapeGroups[group.get()] = std::move(groupShapes);
+    };
+
+    auto loadShapeInstance = [&](const std::shared_ptr<mp::Object>& instance)
+    {
+        mat4 instanceTransformation = transformFromProperties(*instance);
+
+        auto placeGroup = [&](const std::shared_ptr<mp::Object>& child)
+        {
+            if (child->type() != mp::OT_SHAPE || child->pluginType() != "shapegroup")
+            {
+                return;
+            }
+            for (ptr_size s : loadShapeGroup(child))
+            {
+                mitsubaShapes[s].instanceTransformations.push_back(instanceTransformation * mitsubaShapes[s].transformationMatrix);
+            }
+        };
+
+        for (const auto& child : instance->anonymousChildren())
+        {
+            placeGroup(child);
+        }
+        for (const auto& [childName, child] : instance->namedChildren())
+        {
+            (void)childName;
+            placeGroup(child);
+        }
+    };
+
+    auto loadTopLevelObject = [&](const std::shared_ptr<mp::Object>& object)
+    {
+        switch (object->type())
+        {
+        case mp::OT_SHAPE:
+        {
+            if (object->pluginType() == "shapegroup")
             {
-                loadShapeChild(child);
+                loadShapeGroup(object);
+                break;
             }
-            for (const auto& [childName, child] : object->namedChildren())
+            if (object->pluginType() == "instance")
             {
-                (void)childName;
-                loadShapeChild(child);
+                loadShapeInstance(object);
+                break;
             }
-            mitsubaShapes.push_back(shape);
+
+            loadShape(object, false);
             break;
         }
         case mp::OT_BSDF:
@@ -1360,7 +1866,7 @@ void RayceScene::loadFromMitsubaFile(const str& filename, const std::unique_ptr<
             {
                 break;
             }
-            MitsubaBSDF mbsdf = loadMitsubaBSDF(object, imagesToLoad);
+            MitsubaBSDF mbsdf = loadMitsubaBSDF(object, imagesToLoad, spectrumReads);
 
             if (mbsdf.id.empty())
             {
@@ -1392,1096 +1898,929 @@ void RayceScene::loadFromMitsubaFile(const str& filename, const std::unique_ptr<
         loadTopLevelObject(object);
     }
 
+    for (ptr_size s = 0; s < mitsubaShapes.size(); ++s)
+    {
+        if (mitsubaShapes[s].instanced)
+        {
+            mReflectionInfo.meshNames[s] += " (" + std::to_string(mitsubaShapes[s].instanceTransformations.size()) + " instances)";
+        }
+    }
+
+    double conversionMilliseconds = elapsedMilliseconds(phaseTimer) - spectrumReads.milliseconds;
+
     pGeometry = std::make_unique<Geometry>();
 
-    mImages.resize(imagesToLoad.size());
-    mImageViews.resize(imagesToLoad.size());
-    mImageSamplers.resize(imagesToLoad.size());
+    state.compile                = !options.compiledSceneFile.empty();
+    const bool compile           = state.compile;
+    CompiledScene& compiledScene = state.compiledScene;
 
-    for (auto& [ref, bsdf] : mitsubaBSDFs)
+    // textures: references are resolved and deduplicated first, so materials using the same file share one image
+    // decoding runs on worker threads, everything touching vulkan stays in one serial upload stage
+    std::vector<byte> referenceSrgb(imagesToLoad.size(), 1);
+    auto requestTexture = [&referenceSrgb](int32 imageIndex, bool srgb)
     {
-        RAYCE_LOG_INFO("Creating material from %s.", ref.c_str());
-        RAYCE_LOG_INFO("BSDF Type: %d", bsdf.type);
-
-        switch (bsdf.type)
-        {
-        case EBxDFType::lambertDiffuse:
+        if (imageIndex >= 0)
         {
-            if (bsdf.possibleData.diffuseReflectanceTexture >= 0)
-            {
-                // load image;
-                str name = bsdf.id + "_diffuseReflectance";
+            referenceSrgb[imageIndex] = srgb ? 1 : 0;
+        }
+    };
 
-                if (mImageCache[name])
-                {
-                    continue;
-                }
+    for (const auto& [ref, bsdf] : mitsubaBSDFs)
+    {
+        (void)ref;
+        requestTexture(bsdf.possibleData.diffuseReflectanceTexture, true);
+        requestTexture(bsdf.possibleData.specularReflectanceTexture, true);
+        requestTexture(bsdf.possibleData.specularTransmittanceTexture, true);
+        requestTexture(bsdf.possibleData.conductorEtaTexture, false);
+        requestTexture(bsdf.possibleData.conductorKTexture, false);
+        requestTexture(bsdf.possibleData.alphaTexture, false);
+    }
+    for (const MitsubaEmitter& emitter : mitsubaEmitters)
+    {
+        requestTexture(emitter.possibleData.radianceTexture, false);
+    }
 
-                str imageFile = imagesToLoad[bsdf.possibleData.diffuseReflectanceTexture];
+    // the same file is uploaded twice if it is used as color and as data, since the image format differs
+    std::vector<TextureRequest>& textures = state.textures;
+    std::vector<int32> textureRemap(imagesToLoad.size());
+    std::unordered_map<str, int32> textureKeys;
+    for (ptr_size i = 0; i < imagesToLoad.size(); ++i)
+    {
+        TextureRequest texture;
+        texture.filename = resolveTexturePath(imagesToLoad[i], filename);
+        texture.srgb     = referenceSrgb[i] != 0;
+        texture.name     = texture.filename + (texture.srgb ? "#srgb" : "#linear");
 
-                int32 w, h, c;
+        auto it = textureKeys.find(texture.name);
+        if (it != textureKeys.end())
+        {
+            textureRemap[i] = it->second;
+            continue;
+        }
 
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.diffuseReflectanceTexture].c_str(), imageFile.c_str());
-                    }
-                }
+        textureRemap[i]           = static_cast<int32>(textures.size());
+        textureKeys[texture.name] = textureRemap[i];
+        textures.push_back(std::move(texture));
+    }
 
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
+    if (options.hashTextureContent)
+    {
+        // identical files stored under different paths are shared as well
+        parallelFor(
+            textures.size(),
+            [&textures](ptr_size t)
+            {
+                MappedFile file(textures[t].filename);
+                if (file.valid())
                 {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
+                    textures[t].contentHash = hashBytes(file.getData(), file.getSize());
+                    textures[t].contentSize = file.getSize();
                 }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
-
-                VkFormat format = getImageFormat(components, true);
+            },
+            options.parallelTextureDecoding ? 0 : 1);
 
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.diffuseReflectanceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                                     = mImages[bsdf.possibleData.diffuseReflectanceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                mImageViews[bsdf.possibleData.diffuseReflectanceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.diffuseReflectanceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                         VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-            }
-            break;
-        }
-        case EBxDFType::smoothDielectric:
-        case EBxDFType::smoothDielectricThin:
-        case EBxDFType::roughDielectric:
+        std::vector<TextureRequest> uniqueTextures;
+        std::vector<int32> contentRemap(textures.size());
+        std::unordered_map<str, int32> contentKeys;
+        for (ptr_size t = 0; t < textures.size(); ++t)
         {
-            if (bsdf.possibleData.specularReflectanceTexture >= 0)
+            str key = std::to_string(textures[t].contentHash) + "_" + std::to_string(textures[t].contentSize) + (textures[t].srgb ? "#srgb" : "#linear");
+            auto it = contentKeys.find(key);
+            if (textures[t].contentSize > 0 && it != contentKeys.end())
             {
-                // load image;
-                str name = bsdf.id + "_specularReflectance";
-
-                if (mImageCache[name])
-                {
-                    continue;
-                }
-
-                str imageFile = imagesToLoad[bsdf.possibleData.specularReflectanceTexture];
-
-                int32 w, h, c;
+                contentRemap[t] = it->second;
+                continue;
+            }
 
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.specularReflectanceTexture].c_str(), imageFile.c_str());
-                    }
-                }
+            contentRemap[t]  = static_cast<int32>(uniqueTextures.size());
+            contentKeys[key] = contentRemap[t];
+            uniqueTextures.push_back(std::move(textures[t]));
+        }
 
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
+        for (int32& index : textureRemap)
+        {
+            index = contentRemap[index];
+        }
+        textures = std::move(uniqueTextures);
+    }
 
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
+    RAYCE_LOG_INFO("Loading %zu unique textures for %zu texture references.", textures.size(), imagesToLoad.size());
 
-                VkFormat format = getImageFormat(components, true);
+    auto remapTexture = [&textureRemap](int32& imageIndex)
+    {
+        if (imageIndex >= 0)
+        {
+            imageIndex = textureRemap[imageIndex];
+        }
+    };
 
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.specularReflectanceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                                      = mImages[bsdf.possibleData.specularReflectanceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    for (auto& [ref, bsdf] : mitsubaBSDFs)
+    {
+        (void)ref;
+        remapTexture(bsdf.possibleData.diffuseReflectanceTexture);
+        remapTexture(bsdf.possibleData.specularReflectanceTexture);
+        remapTexture(bsdf.possibleData.specularTransmittanceTexture);
+        remapTexture(bsdf.possibleData.conductorEtaTexture);
+        remapTexture(bsdf.possibleData.conductorKTexture);
+        remapTexture(bsdf.possibleData.alphaTexture);
+    }
+    for (MitsubaEmitter& emitter : mitsubaEmitters)
+    {
+        remapTexture(emitter.possibleData.radianceTexture);
+    }
 
-                mImageViews[bsdf.possibleData.specularReflectanceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.specularReflectanceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                          VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-            }
-            if (bsdf.possibleData.specularTransmittanceTexture >= 0)
-            {
-                // load image;
-                str name = bsdf.id + "_specularTransmittance";
+    // all texture slots exist from the start, so material texture indices and descriptor counts never change
+    // while a progressive load replaces the placeholders
+    mImages.resize(textures.size());
+    mImageViews.resize(textures.size());
+    mImageSamplers.resize(textures.size());
+    if (options.progressive)
+    {
+        const byte placeholder[STBI_rgb_alpha] = { 255, 255, 255, 255 };
+        for (ptr_size i = 0; i < textures.size(); ++i)
+        {
+            uploadTexture(logicalDevice, commandPool, placeholder, 1, 1, STBI_rgb_alpha, textures[i].srgb, mImages[i], mImageViews[i], mImageSamplers[i]);
+        }
+    }
 
-                if (mImageCache[name])
-                {
-                    continue;
-                }
+    if (compile)
+    {
+        compiledScene.textures.resize(textures.size());
+    }
 
-                str imageFile = imagesToLoad[bsdf.possibleData.specularTransmittanceTexture];
+    phaseTimer.restart();
+    for (auto& [ref, bsdf] : mitsubaBSDFs)
+    {
+        RAYCE_LOG_INFO("Creating material from %s.", ref.c_str());
+        RAYCE_LOG_INFO("BSDF Type: %d", bsdf.type);
 
-                int32 w, h, c;
+        if (bsdf.type == EBxDFType::bsdfTypeCount)
+        {
+            RAYCE_LOG_WARN("Unsupported bsdf!");
+        }
 
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.specularTransmittanceTexture].c_str(), imageFile.c_str());
-                    }
-                }
+        bsdf.materialId = mMaterials.size();
+        mMaterials.push_back(std::make_unique<Material>(bsdf.possibleData));
+    }
 
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
+    str name = "Default";
+    RAYCE_LOG_INFO("Loading texture %s.", name.c_str());
 
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
+    mImageCache[name]    = static_cast<byte*>(STBI_MALLOC(1));
+    mImageCache[name][0] = 0;
 
-                VkFormat format = getImageFormat(components, true);
+    mImages.emplace_back();
+    mImageViews.emplace_back();
+    mImageSamplers.emplace_back();
+    uploadTexture(logicalDevice, commandPool, mImageCache[name], 1, 1, 1, false, mImages.back(), mImageViews.back(), mImageSamplers.back());
 
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.specularTransmittanceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                                        = mImages[bsdf.possibleData.specularTransmittanceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (compile)
+    {
+        compiledScene.textures.push_back({ 1, 1, 1, false, std::span<const byte>(mImageCache[name], 1) });
+    }
 
-                mImageViews[bsdf.possibleData.specularTransmittanceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.specularTransmittanceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                            VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-            }
+    // emitters -> lights
+    int32 emitterId = 0;
+    for (auto& emitter : mitsubaEmitters)
+    {
+        RAYCE_LOG_INFO("Creating light from emitter %d.", emitterId);
+        emitter.possibleData.type = emitter.type;
 
-            if (bsdf.type == EBxDFType::roughDielectric)
-            {
-                if (bsdf.possibleData.alphaTexture >= 0)
-                {
-                    // load image;
-                    str name = bsdf.id + "_alpha";
+        if (emitter.type != ELightType::area && emitter.type != ELightType::constant)
+        {
+            RAYCE_LOG_WARN("Unsupported emitter!");
+        }
 
-                    if (mImageCache[name])
-                    {
-                        continue;
-                    }
+        emitter.lightId = mLights.size();
+        mLights.push_back(std::make_unique<Light>(emitter.possibleData));
 
-                    str imageFile = imagesToLoad[bsdf.possibleData.alphaTexture];
+        emitterId++;
+    }
 
-                    int32 w, h, c;
+    addLoadTiming(ESceneLoadPhase::conversion, conversionMilliseconds + elapsedMilliseconds(phaseTimer), 0);
 
-                    if (!fs::exists(imageFile))
-                    {
-                        imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                        if (!fs::exists(imageFile))
-                        {
-                            RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.alphaTexture].c_str(), imageFile.c_str());
-                        }
-                    }
+    // shapes -> meshes
+    state.sceneBounds.minimum = vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    state.sceneBounds.maximum = vec3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
 
-                    mImageCache[name] =
-                        stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                    if (!mImageCache[name])
-                    {
-                        RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                    }
-                    RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                    uint32 width      = static_cast<uint32>(w);
-                    uint32 height     = static_cast<uint32>(h);
-                    uint32 components = STBI_rgb_alpha;
-                    uint32 imageSize  = width * height * components;
-
-                    VkFormat format = getImageFormat(components, false);
-
-                    VkExtent2D extent{ width, height };
-                    mImages[bsdf.possibleData.alphaTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                    auto& addedImage                        = mImages[bsdf.possibleData.alphaTexture];
-                    addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                    VkExtent3D extent3D{ width, height, 1 };
-                    Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                    mImageViews[bsdf.possibleData.alphaTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                    mImageSamplers[bsdf.possibleData.alphaTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-                }
-            }
-            break;
-        }
-        case EBxDFType::smoothConductor:
-        case EBxDFType::roughConductor:
+    // shapes referencing the same mesh file share one geometry and BLAS, only the first of them loads the file
+    state.meshInstances.resize(mitsubaShapes.size());
+    std::unordered_map<str, ptr_size> meshSourceKeys;
+    for (ptr_size s = 0; s < mitsubaShapes.size(); ++s)
+    {
+        // grouped shapes that are never instanced are not loaded at all
+        if (!isTriangleMesh(mitsubaShapes[s]) || shapeTransformations(mitsubaShapes[s]).empty())
         {
+            continue;
+        }
 
-            if (bsdf.possibleData.specularReflectanceTexture >= 0)
+        if (options.shareMeshes)
+        {
+            std::error_code error;
+            str key = fs::weakly_canonical(mitsubaShapes[s].filename, error).generic_string() + "#" + std::to_string(mitsubaShapes[s].shapeIndex);
+            auto it = meshSourceKeys.find(key);
+            if (it != meshSourceKeys.end())
             {
-                // load image;
-                str name = bsdf.id + "_specularReflectance";
-
-                if (mImageCache[name])
-                {
-                    continue;
-                }
-
-                str imageFile = imagesToLoad[bsdf.possibleData.specularReflectanceTexture];
-
-                int32 w, h, c;
-
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.specularReflectanceTexture].c_str(), imageFile.c_str());
-                    }
-                }
-
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
-
-                VkFormat format = getImageFormat(components, true);
-
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.specularReflectanceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                                      = mImages[bsdf.possibleData.specularReflectanceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                mImageViews[bsdf.possibleData.specularReflectanceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.specularReflectanceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                          VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
+                state.meshInstances[it->second].push_back(s);
+                continue;
             }
-            if (bsdf.possibleData.conductorEtaTexture >= 0)
-            {
-                // load image;
-                str name = bsdf.id + "_conductorEtaTexture";
-
-                if (mImageCache[name])
-                {
-                    continue;
-                }
-
-                str imageFile = imagesToLoad[bsdf.possibleData.conductorEtaTexture];
+            meshSourceKeys[key] = s;
+        }
 
-                int32 w, h, c;
+        state.meshSources.push_back(s);
+        state.meshInstances[s].push_back(s);
+    }
 
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.conductorEtaTexture].c_str(), imageFile.c_str());
-                    }
-                }
+    if (compile)
+    {
+        // the compiled scene is out of date as soon as one of the files it was loaded from changes
+        compiledScene.optionsHash = hashCompiledSceneOptions(options);
+        compiledScene.sourceFiles.push_back(filename);
+        for (ptr_size s : state.meshSources)
+        {
+            compiledScene.sourceFiles.push_back(mitsubaShapes[s].filename);
+        }
+        for (const TextureRequest& texture : textures)
+        {
+            compiledScene.sourceFiles.push_back(texture.filename);
+        }
+        std::sort(compiledScene.sourceFiles.begin(), compiledScene.sourceFiles.end());
+        compiledScene.sourceFiles.erase(std::unique(compiledScene.sourceFiles.begin(), compiledScene.sourceFiles.end()), compiledScene.sourceFiles.end());
+    }
 
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
+    state.meshes.resize(mitsubaShapes.size());
+    state.meshChunks.resize(mitsubaShapes.size());
+    state.meshLoaded.resize(mitsubaShapes.size(), 0);
+    state.meshLoadMilliseconds.resize(mitsubaShapes.size(), 0.0);
+    state.remainingMeshes   = state.meshSources.size();
+    state.remainingTextures = textures.size();
 
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
+    if (options.progressive)
+    {
+        RAYCE_LOG_INFO("Loading %zu meshes and %zu textures in the background.", state.meshSources.size(), textures.size());
+        state.worker = std::thread(runSceneLoadJobs, std::ref(state));
+        return;
+    }
 
-                VkFormat format = getImageFormat(components, false);
+    runSceneLoadJobs(state);
+    updateProgressiveLoad(logicalDevice, commandPool);
+}
 
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.conductorEtaTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                               = mImages[bsdf.possibleData.conductorEtaTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+bool RayceScene::updateProgressiveLoad(const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool)
+{
+    if (!pLoadState)
+    {
+        return false;
+    }
 
-                mImageViews[bsdf.possibleData.conductorEtaTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.conductorEtaTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                   VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-            }
-            if (bsdf.possibleData.conductorKTexture >= 0)
-            {
-                // load image;
-                str name = bsdf.id + "_conductorKTexture";
+    SceneLoadState& state = *pLoadState;
 
-                if (mImageCache[name])
-                {
-                    continue;
-                }
+    std::vector<ptr_size> readyMeshes;
+    std::vector<ptr_size> readyTextures;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        readyMeshes.swap(state.readyMeshes);
+        readyTextures.swap(state.readyTextures);
+    }
 
-                str imageFile = imagesToLoad[bsdf.possibleData.conductorKTexture];
+    // workers finish in any order, sorting keeps a blocking load deterministic and in shape order
+    std::sort(readyMeshes.begin(), readyMeshes.end());
+    std::sort(readyTextures.begin(), readyTextures.end());
 
-                int32 w, h, c;
+    bool changed = false;
 
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.conductorKTexture].c_str(), imageFile.c_str());
-                    }
-                }
+    for (ptr_size t : readyTextures)
+    {
+        TextureRequest& texture = state.textures[t];
+        if (!texture.pixels)
+        {
+            // keep the texture index valid, a missing image is replaced by a single white pixel
+            texture.width  = 1;
+            texture.height = 1;
+            texture.pixels = static_cast<byte*>(STBI_MALLOC(STBI_rgb_alpha));
+            std::fill_n(texture.pixels, STBI_rgb_alpha, static_cast<byte>(255));
+        }
 
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
+        mImageCache[texture.name] = texture.pixels;
 
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
+        Timer timer;
+        timer.start();
+        uploadTexture(logicalDevice, commandPool, texture.pixels, static_cast<uint32>(texture.width), static_cast<uint32>(texture.height), STBI_rgb_alpha, texture.srgb, mImages[t], mImageViews[t],
+                      mImageSamplers[t]);
 
-                VkFormat format = getImageFormat(components, false);
+        SceneLoadItemTiming timing;
+        timing.name               = texture.name;
+        timing.loadMilliseconds   = texture.decodeMilliseconds;
+        timing.uploadMilliseconds = elapsedMilliseconds(timer);
+        timing.fileBytes          = fileSize(texture.filename);
+        timing.uploadBytes        = static_cast<uint64>(texture.width) * texture.height * STBI_rgb_alpha;
+        addLoadTiming(ESceneLoadPhase::textureDecode, timing.loadMilliseconds, timing.fileBytes);
+        addLoadTiming(ESceneLoadPhase::textureUpload, timing.uploadMilliseconds, timing.uploadBytes);
+        mReflectionInfo.textureLoadTimings.push_back(timing);
 
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.conductorKTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                             = mImages[bsdf.possibleData.conductorKTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        if (state.compile)
+        {
+            state.compiledScene.textures[t] = { static_cast<uint32>(texture.width), static_cast<uint32>(texture.height), STBI_rgb_alpha, texture.srgb,
+                                                std::span<const byte>(texture.pixels, static_cast<ptr_size>(texture.width) * texture.height * STBI_rgb_alpha) };
+        }
 
-                mImageViews[bsdf.possibleData.conductorKTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.conductorKTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                 VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-            }
+        // the cache owns the pixels now
+        texture.pixels = nullptr;
+        state.remainingTextures--;
+        changed = true;
+    }
 
-            if (bsdf.type == EBxDFType::roughConductor)
+    if (!state.spheresAdded)
+    {
+        // spheres are not loaded from files, they are part of the first batch
+        for (ptr_size s = 0; s < state.shapes.size(); ++s)
+        {
+            if (state.shapes[s].type == EShapeType::sphere)
             {
-                if (bsdf.possibleData.alphaTexture >= 0)
-                {
-                    // load image;
-                    str name = bsdf.id + "_alpha";
-
-                    if (mImageCache[name])
-                    {
-                        continue;
-                    }
-
-                    str imageFile = imagesToLoad[bsdf.possibleData.alphaTexture];
-
-                    int32 w, h, c;
-
-                    if (!fs::exists(imageFile))
-                    {
-                        imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                        if (!fs::exists(imageFile))
-                        {
-                            RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.alphaTexture].c_str(), imageFile.c_str());
-                        }
-                    }
-
-                    mImageCache[name] =
-                        stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                    if (!mImageCache[name])
-                    {
-                        RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                    }
-                    RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                    uint32 width      = static_cast<uint32>(w);
-                    uint32 height     = static_cast<uint32>(h);
-                    uint32 components = STBI_rgb_alpha;
-                    uint32 imageSize  = width * height * components;
-
-                    VkFormat format = getImageFormat(components, false);
-
-                    VkExtent2D extent{ width, height };
-                    mImages[bsdf.possibleData.alphaTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                    auto& addedImage                        = mImages[bsdf.possibleData.alphaTexture];
-                    addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                    VkExtent3D extent3D{ width, height, 1 };
-                    Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                    mImageViews[bsdf.possibleData.alphaTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                    mImageSamplers[bsdf.possibleData.alphaTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-                }
+                addSphereShape(state, s);
+                changed = true;
             }
-            break;
         }
-        case EBxDFType::smoothPlastic:
-        case EBxDFType::roughPlastic:
-        {
-            if (bsdf.possibleData.diffuseReflectanceTexture >= 0)
-            {
-                // load image;
-                str name = bsdf.id + "_diffuseReflectance";
-
-                if (mImageCache[name])
-                {
-                    continue;
-                }
-
-                str imageFile = imagesToLoad[bsdf.possibleData.diffuseReflectanceTexture];
-
-                int32 w, h, c;
-
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.diffuseReflectanceTexture].c_str(), imageFile.c_str());
-                    }
-                }
-
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
+        state.spheresAdded = true;
+    }
 
-                VkFormat format = getImageFormat(components, true);
+    for (ptr_size source : readyMeshes)
+    {
+        if (state.meshLoaded[source])
+        {
+            addMeshShapes(state, source, logicalDevice, commandPool);
+            changed = true;
+        }
+        state.remainingMeshes--;
+    }
 
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.diffuseReflectanceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                                     = mImages[bsdf.possibleData.diffuseReflectanceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // merged meshes are collected until all meshes are loaded or the triangle budget of a merged mesh is reached
+    if (state.remainingMeshes == 0 && flushMergedMeshes(state, logicalDevice, commandPool))
+    {
+        changed = true;
+    }
 
-                mImageViews[bsdf.possibleData.diffuseReflectanceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.diffuseReflectanceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                         VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-            }
-            if (bsdf.possibleData.specularReflectanceTexture >= 0)
+    if (changed)
+    {
+        for (auto& light : mLights)
+        {
+            if (light->type == ELightType::constant)
             {
-                // load image;
-                str name = bsdf.id + "_specularReflectance";
-
-                if (mImageCache[name])
-                {
-                    continue;
-                }
-
-                str imageFile = imagesToLoad[bsdf.possibleData.specularReflectanceTexture];
-
-                int32 w, h, c;
-
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.specularReflectanceTexture].c_str(), imageFile.c_str());
-                    }
-                }
-
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
-
-                VkFormat format = getImageFormat(components, true);
-
-                VkExtent2D extent{ width, height };
-                mImages[bsdf.possibleData.specularReflectanceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                                      = mImages[bsdf.possibleData.specularReflectanceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                mImageViews[bsdf.possibleData.specularReflectanceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[bsdf.possibleData.specularReflectanceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                          VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
+                light->wCenter     = float3::Zero();
+                light->sceneRadius = std::max(state.sceneBounds.maximum.norm(), state.sceneBounds.minimum.norm());
             }
+        }
+    }
 
-            if (bsdf.type == EBxDFType::roughPlastic)
-            {
-                if (bsdf.possibleData.alphaTexture >= 0)
-                {
-                    // load image;
-                    str name = bsdf.id + "_alpha";
+    if (state.remainingMeshes == 0 && state.remainingTextures == 0)
+    {
+        finishSceneLoad();
+    }
 
-                    if (mImageCache[name])
-                    {
-                        continue;
-                    }
+    return changed;
+}
 
-                    str imageFile = imagesToLoad[bsdf.possibleData.alphaTexture];
+bool RayceScene::isLoading() const
+{
+    return pLoadState != nullptr;
+}
 
-                    int32 w, h, c;
+void RayceScene::getLoadProgress(uint32& loadedMeshes, uint32& meshCount, uint32& loadedTextures, uint32& textureCount) const
+{
+    loadedMeshes   = 0;
+    meshCount      = 0;
+    loadedTextures = 0;
+    textureCount   = 0;
+    if (!pLoadState)
+    {
+        return;
+    }
 
-                    if (!fs::exists(imageFile))
-                    {
-                        imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                        if (!fs::exists(imageFile))
-                        {
-                            RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[bsdf.possibleData.alphaTexture].c_str(), imageFile.c_str());
-                        }
-                    }
+    meshCount      = static_cast<uint32>(pLoadState->meshSources.size());
+    loadedMeshes   = meshCount - static_cast<uint32>(pLoadState->remainingMeshes);
+    textureCount   = static_cast<uint32>(pLoadState->textures.size());
+    loadedTextures = textureCount - static_cast<uint32>(pLoadState->remainingTextures);
+}
 
-                    mImageCache[name] =
-                        stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                    if (!mImageCache[name])
-                    {
-                        RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                    }
-                    RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                    uint32 width      = static_cast<uint32>(w);
-                    uint32 height     = static_cast<uint32>(h);
-                    uint32 components = STBI_rgb_alpha;
-                    uint32 imageSize  = width * height * components;
-
-                    VkFormat format = getImageFormat(components, false);
-
-                    VkExtent2D extent{ width, height };
-                    mImages[bsdf.possibleData.alphaTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                    auto& addedImage                        = mImages[bsdf.possibleData.alphaTexture];
-                    addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                    VkExtent3D extent3D{ width, height, 1 };
-                    Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-                    mImageViews[bsdf.possibleData.alphaTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                    mImageSamplers[bsdf.possibleData.alphaTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
-                }
-            }
-            break;
-        }
-        default:
-            RAYCE_LOG_WARN("Unsupported bsdf!");
-            break;
+void RayceScene::addMeshShapes(SceneLoadState& state, ptr_size source, const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool)
+{
+    MeshData& mesh                   = state.meshes[source];
+    std::span<const Vertex> vertices = mesh.getVertices();
+    std::span<const uint32> indices  = mesh.getIndices();
+    const uint32 vertexCount         = static_cast<uint32>(vertices.size());
+    const uint32 sourceVertexCount   = mesh.sourceVertexCount;
+    const uint32 primitiveCount      = static_cast<uint32>(indices.size() / 3);
+
+    // small meshes placed once are baked into the pending merged mesh instead of getting a BLAS and instance of their own,
+    // emitters keep their own geometry since lights reference a single shape
+    const std::vector<ptr_size>& placements = state.meshInstances[source];
+    const bool merge = state.options.mergeTriangleLimit > 0 && primitiveCount <= state.options.mergeTriangleLimit && state.meshChunks[source].empty() && placements.size() == 1 &&
+                       shapeTransformations(state.shapes[placements[0]]).size() == 1 && state.shapes[placements[0]].emitter < 0;
+
+    // a split mesh is uploaded chunk by chunk, every chunk becomes a geometry with its own BLAS
+    std::vector<MeshData>& chunks = state.meshChunks[source];
+    std::vector<const MeshData*> parts;
+    if (chunks.empty() && !merge)
+    {
+        parts.push_back(&mesh);
+    }
+    else if (!chunks.empty())
+    {
+        RAYCE_LOG_INFO("Split %s into %llu chunks.", mReflectionInfo.meshNames[source].c_str(), static_cast<uint64>(chunks.size()));
+        for (const MeshData& chunk : chunks)
+        {
+            parts.push_back(&chunk);
         }
-
-        bsdf.materialId = mMaterials.size();
-        mMaterials.push_back(std::make_unique<Material>(bsdf.possibleData));
     }
 
-    str name = "Default";
-    RAYCE_LOG_INFO("Loading texture %s.", name.c_str());
-
-    uint32 width      = 1;
-    uint32 height     = 1;
-    uint32 components = 1;
-    uint32 imageSize  = width * height * components;
+    Timer timer;
+    timer.start();
 
-    mImageCache[name]    = new byte[imageSize];
-    mImageCache[name][0] = 0;
-
-    VkFormat format = getImageFormat(components, false);
+    struct UploadedPart
+    {
+        std::unique_ptr<Buffer> positionBuffer;
+        std::unique_ptr<Buffer> attributeBuffer;
+        std::unique_ptr<Buffer> indexBuffer;
+        VkIndexType indexType;
+    };
+    std::vector<UploadedPart> uploadedParts(parts.size());
+    VkDeviceSize uploadBytes = 0;
+    for (ptr_size p = 0; p < parts.size(); ++p)
+    {
+        UploadedPart& part = uploadedParts[p];
+        uploadBytes += createMeshBuffers(logicalDevice, commandPool, parts[p]->getVertices(), parts[p]->getIndices(), parts[p]->hasNormals || parts[p]->hasUVs, state.options.shortIndices,
+                                         state.options.compactAttributes, part.positionBuffer, part.attributeBuffer, part.indexBuffer, part.indexType);
+    }
 
-    VkExtent2D extent{ width, height };
-    mImages.push_back(std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-    auto& addedImage = mImages.back();
-    addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    VkExtent3D extent3D{ width, height, 1 };
-    Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-    addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // welding is part of loading the file, a mesh cache hit does not weld at all
+    SceneLoadItemTiming timing;
+    timing.name               = mReflectionInfo.meshNames[source];
+    timing.weldMilliseconds   = mesh.weldMilliseconds;
+    timing.loadMilliseconds   = state.meshLoadMilliseconds[source] - mesh.weldMilliseconds;
+    timing.uploadMilliseconds = elapsedMilliseconds(timer);
+    timing.fileBytes          = fileSize(state.shapes[source].filename);
+    timing.uploadBytes        = uploadBytes;
+    addLoadTiming(ESceneLoadPhase::meshParse, timing.loadMilliseconds, timing.fileBytes);
+    if (timing.weldMilliseconds > 0.0)
+    {
+        addLoadTiming(ESceneLoadPhase::meshWeld, timing.weldMilliseconds, vertices.size_bytes());
+    }
+    addLoadTiming(ESceneLoadPhase::meshUpload, timing.uploadMilliseconds, timing.uploadBytes);
+    mReflectionInfo.meshLoadTimings.push_back(timing);
 
-    mImageViews.push_back(std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-    mImageSamplers.push_back(std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                       VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
+    const ptr_size geometryIndex = pGeometry->getTriangleMeshes().size();
+    bool geometryAdded           = false;
 
-    // emitters -> lights
-    int32 emitterId = 0;
-    for (auto& emitter : mitsubaEmitters)
+    // the first placement creates the geometry, all other shapes using the same file and all instances of
+    // grouped shapes are TLAS instances of it
+    for (ptr_size s : state.meshInstances[source])
     {
-        RAYCE_LOG_INFO("Creating light from emitter %d.", emitterId);
-        emitter.possibleData.type = emitter.type;
+        const MitsubaShape& shape = state.shapes[s];
 
-        switch (emitter.type)
-        {
-        case ELightType::area:
-        case ELightType::constant:
+        // materialId is filled before
+        uint32 materialId = state.bsdfs[shape.bsdf].materialId;
+        int32 lightId     = -1;
+        if (shape.emitter >= 0)
         {
-            if (emitter.possibleData.radianceTexture >= 0)
+            lightId                           = state.emitters[shape.emitter].lightId;
+            std::unique_ptr<Light>& lightData = mLights[lightId];
+            if (shape.type == EShapeType::rectangle)
             {
-                // load image;
-                str name = "emitter_" + std::to_string(emitterId) + "_radiance";
-
-                if (mImageCache[name])
-                {
-                    continue;
-                }
-
-                str imageFile = imagesToLoad[emitter.possibleData.radianceTexture];
-
-                int32 w, h, c;
-
-                if (!fs::exists(imageFile))
-                {
-                    imageFile = fs::path(filename).parent_path().concat("/" + imageFile).string();
-                    if (!fs::exists(imageFile))
-                    {
-                        RAYCE_LOG_ERROR("Can not find %s nor %s", imagesToLoad[emitter.possibleData.radianceTexture].c_str(), imageFile.c_str());
-                    }
-                }
-
-                mImageCache[name] =
-                    stbi_load(imageFile.c_str(), &w, &h, &c, STBI_rgb_alpha);
-                if (!mImageCache[name])
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s", imageFile.c_str());
-                }
-                RAYCE_LOG_INFO("Loaded %s as %s", imageFile.c_str(), name.c_str());
-
-                uint32 width      = static_cast<uint32>(w);
-                uint32 height     = static_cast<uint32>(h);
-                uint32 components = STBI_rgb_alpha;
-                uint32 imageSize  = width * height * components;
-
-                VkFormat format = getImageFormat(components, false);
+                // convert light data to our type
+                assert(lightData->type == ELightType::area); // atm analytic rectangle
 
-                VkExtent2D extent{ width, height };
-                mImages[emitter.possibleData.radianceTexture] = (std::make_unique<Image>(logicalDevice, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-                auto& addedImage                              = mImages[emitter.possibleData.radianceTexture];
-                addedImage->allocateMemory(logicalDevice, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-                VkExtent3D extent3D{ width, height, 1 };
-                Image::uploadImageDataWithStagingBuffer(logicalDevice, commandPool, *addedImage, mImageCache[name], imageSize, extent3D);
-                addedImage->adaptImageLayout(logicalDevice, commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                lightData->type = ELightType::analyticRectangle;
 
-                mImageViews[emitter.possibleData.radianceTexture]    = (std::make_unique<ImageView>(logicalDevice, *addedImage, format, VK_IMAGE_ASPECT_COLOR_BIT));
-                mImageSamplers[emitter.possibleData.radianceTexture] = (std::make_unique<Sampler>(logicalDevice, VK_FILTER_LINEAR, VK_FILTER_LINEAR,
-                                                                                                  VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_MIPMAP_MODE_LINEAR, true, false, VK_COMPARE_OP_ALWAYS)); // default sampler
+                lightData->wCenter      = (shape.transformationMatrix * vec4(0.0, 0.0, 0.0, 1.0)).head<3>(); // rectangle is xy [-1, 1]
+                vec3 tmp                = (shape.transformationMatrix.block<3, 3>(0, 0) * vec3(2.0, 2.0, 0.0));
+                lightData->surfaceArea  = std::abs(tmp.squaredNorm());
+                lightData->lightToWorld = shape.transformationMatrix;
+                lightData->worldToLight = shape.transformationMatrix.inverse();
             }
-
-            break;
-        }
-        default:
-            RAYCE_LOG_WARN("Unsupported emitter!");
-            break;
         }
 
-        emitter.lightId = mLights.size();
-        mLights.push_back(std::make_unique<Light>(emitter.possibleData));
-
-        emitterId++;
-    }
+        mMaterials[materialId]->canUseUv = mesh.hasUVs;
 
-    // shapes -> meshes
-    AxisAlignedBoundingBox sceneBounds;
-    sceneBounds.minimum = vec3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-    sceneBounds.maximum = vec3(std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min());
+        mReflectionInfo.meshTriCounts[s] += primitiveCount;
+        mReflectionInfo.meshSourceTriCounts[s] += mesh.sourceTriangleCount;
+        mReflectionInfo.meshVertexCounts[s] += vertexCount;
+        mReflectionInfo.meshSourceVertexCounts[s] += sourceVertexCount;
+        mReflectionInfo.meshCacheMissesBefore[s] = mesh.cacheMissesBefore;
+        mReflectionInfo.meshCacheMissesAfter[s]  = mesh.cacheMissesAfter;
 
-    uint32 meshId   = 0;
-    uint32 sphereId = 0;
-    for (auto& shape : mitsubaShapes)
-    {
-        if (shape.type == EShapeType::triangleMesh || shape.type == EShapeType::rectangle || shape.type == EShapeType::cube)
+        for (const mat4& transformation : shapeTransformations(shape))
         {
-            str ext = shape.filename.substr(shape.filename.find_last_of(".") + 1);
+            // the object space bounds are computed while loading, only their corners are transformed
+            AxisAlignedBoundingBox meshBounds = transformBounds(mesh.bounds, transformation);
+            state.sceneBounds.minimum         = state.sceneBounds.minimum.cwiseMin(meshBounds.minimum);
+            state.sceneBounds.maximum         = state.sceneBounds.maximum.cwiseMax(meshBounds.maximum);
 
-            if (ext == "ply")
+            if (merge)
             {
-                RAYCE_LOG_INFO("Loading: %s.", shape.filename.c_str());
-                miniply::PLYReader plyReader(shape.filename.c_str());
-
-                if (!plyReader.valid())
-                {
-                    RAYCE_LOG_ERROR("Can not load: %s!", shape.filename.c_str());
-                    continue;
-                }
-
-                bool hasPositions = false, hasIndices = false, hasNormals = false, hasUVs = false;
-                uint32 positionIndices[3];
-                uint32 normalIndices[3];
-                uint32 uvIndices[2];
-                uint32 indexIndex;
-                std::vector<uint32> indices;
-                std::vector<vec3> positions;
-                std::vector<vec3> normals;
-                std::vector<vec2> uvs;
-
-                while (plyReader.has_element() && (!hasPositions || !hasIndices || !hasNormals || !hasUVs))
-                {
-                    if (plyReader.element_is(miniply::kPLYVertexElement))
-                    {
-                        if (!plyReader.load_element())
-                        {
-                            RAYCE_LOG_ERROR("Can not load index element. Canceling the loading process!");
-                            break;
-                        }
-
-                        if (!plyReader.find_pos(positionIndices))
-                        {
-                            RAYCE_LOG_ERROR("Can not find position properties. Canceling the loading process!");
-                            break;
-                        }
-
-                        hasPositions = true;
-                        positions.resize(plyReader.num_rows());
-                        plyReader.extract_properties(positionIndices, 3, miniply::PLYPropertyType::Float, positions.data());
-
-                        if (plyReader.find_normal(normalIndices))
-                        {
-                            hasNormals = true;
-                            normals.resize(plyReader.num_rows());
-                            plyReader.extract_properties(normalIndices, 3, miniply::PLYPropertyType::Float, normals.data());
-                        }
-
-                        if (plyReader.find_texcoord(uvIndices))
-                        {
-                            hasUVs = true;
-                            uvs.resize(plyReader.num_rows());
-                            plyReader.extract_properties(uvIndices, 2, miniply::PLYPropertyType::Float, uvs.data());
-                        }
-                    }
-                    else if (!hasIndices && plyReader.element_is(miniply::kPLYFaceElement))
-                    {
-                        if (!plyReader.load_element())
-                        {
-                            RAYCE_LOG_ERROR("Can not load face element. Canceling the loading process!");
-                            break;
-                        }
-
-                        if (!plyReader.find_indices(&indexIndex))
-                        {
-                            RAYCE_LOG_ERROR("Can not find index properties. Canceling the loading process!");
-                            break;
-                        }
-
-                        hasIndices = true;
-
-                        bool hasPolygons = plyReader.requires_triangulation(indexIndex);
-
-                        if (hasPolygons)
-                        {
-                            if (!hasPositions)
-                            {
-                                RAYCE_LOG_ERROR("Can not triangulate before finding vertex data. Canceling the loading process!");
-                                break;
-                            }
-                            indices.resize(plyReader.num_triangles(indexIndex) * 3);
-                            plyReader.extract_triangles(indexIndex, reinterpret_cast<float*>(positions.data()), positions.size(), miniply::PLYPropertyType::Int, indices.data());
-                        }
-                        else
-                        {
-                            indices.resize(plyReader.num_rows() * 3);
-                            plyReader.extract_list_property(indexIndex, miniply::PLYPropertyType::Int, indices.data());
-                        }
-                    }
-
-                    plyReader.next_element();
-                }
-
-                if (!(hasPositions && hasIndices))
-                {
-                    RAYCE_LOG_ERROR("%s has no positions or indices!", shape.filename.c_str());
-                    continue;
-                }
+                appendTransformedMesh(mesh, transformation, state.pendingMerge.mesh);
+                state.pendingMerge.triangleMaterialIds.insert(state.pendingMerge.triangleMaterialIds.end(), primitiveCount, materialId);
+                state.pendingMerge.shapeCount++;
+                continue;
+            }
 
-                std::vector<Vertex> vertices(positions.size());
-                for (ptr_size v = 0; v < positions.size(); ++v)
+            if (!geometryAdded)
+            {
+                for (ptr_size p = 0; p < parts.size(); ++p)
                 {
-                    Vertex vertex;
-
-                    vertex.position = positions[v];
-                    vertex.normal   = hasNormals ? normals[v].normalized() : vec3(0.0, 0.0, 0.0);
-                    vertex.uv       = hasUVs ? uvs[v] : vec2(1.0, 1.0);
-
-                    sceneBounds.minimum = sceneBounds.minimum.cwiseMin((shape.transformationMatrix * vertex.position.homogeneous()).head<3>());
-                    sceneBounds.maximum = sceneBounds.maximum.cwiseMax((shape.transformationMatrix * vertex.position.homogeneous()).head<3>());
-
-                    vertices[v] = vertex;
-                }
-
-                std::unique_ptr<Buffer> vertexBuffer = std::make_unique<Buffer>(logicalDevice, sizeof(Vertex) * vertices.size(),
-                                                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-                                                                                    VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-                std::unique_ptr<Buffer> indexBuffer  = std::make_unique<Buffer>(logicalDevice, sizeof(uint32) * indices.size(),
-                                                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-                                                                                    VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-
-                vertexBuffer->allocateMemory(logicalDevice, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                indexBuffer->allocateMemory(logicalDevice, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                    UploadedPart& part      = uploadedParts[p];
+                    const uint32 partCount  = static_cast<uint32>(parts[p]->getIndices().size() / 3);
+                    const uint32 partVertex = static_cast<uint32>(parts[p]->getVertices().size()) - 1;
+                    pGeometry->add(std::move(part.positionBuffer), std::move(part.attributeBuffer), state.options.compactAttributes, partVertex, std::move(part.indexBuffer), part.indexType, partCount,
+                                   materialId, lightId, { transformation });
 
-                Buffer::uploadDataWithStagingBuffer(logicalDevice, commandPool, *vertexBuffer, vertices);
-                Buffer::uploadDataWithStagingBuffer(logicalDevice, commandPool, *indexBuffer, indices);
-
-                uint32 maxVertex      = static_cast<uint32>(vertices.size() - 1);
-                uint32 primitiveCount = static_cast<uint32>(indices.size() / 3);
-                mReflectionInfo.meshTriCounts[meshId + sphereId] += primitiveCount;
-
-                // materialId is filled before
-                uint32 materialId = mitsubaBSDFs[shape.bsdf].materialId;
-                int32 lightId     = -1;
-                if (shape.emitter >= 0)
-                {
-                    lightId                           = mitsubaEmitters[shape.emitter].lightId;
-                    std::unique_ptr<Light>& lightData = mLights[lightId];
-                    if (shape.type == EShapeType::rectangle)
+                    if (state.compile)
                     {
-                        // convert light data to our type
-                        assert(lightData->type == ELightType::area); // atm analytic rectangle
-
-                        lightData->type = ELightType::analyticRectangle;
-
-                        lightData->wCenter      = (shape.transformationMatrix * vec4(0.0, 0.0, 0.0, 1.0)).head<3>(); // rectangle is xy [-1, 1]
-                        vec3 tmp                = (shape.transformationMatrix.block<3, 3>(0, 0) * vec3(2.0, 2.0, 0.0));
-                        lightData->surfaceArea  = std::abs(tmp.squaredNorm());
-                        lightData->lightToWorld = shape.transformationMatrix;
-                        lightData->worldToLight = shape.transformationMatrix.inverse();
+                        state.compiledScene.meshes.push_back({ parts[p]->getVertices(), parts[p]->getIndices(), { materialId }, { lightId }, { transformation }, {}, parts[p]->hasNormals || parts[p]->hasUVs });
                     }
                 }
-
-                mMaterials[materialId]->canUseUv = hasUVs;
-
-                pGeometry->add(std::move(vertexBuffer), maxVertex, std::move(indexBuffer), primitiveCount, materialId, lightId, { shape.transformationMatrix });
+                geometryAdded = true;
+                continue;
             }
 
-            if (ext == "obj")
+            // another instance of the uploaded mesh, every chunk gets the same material, light and transformation
+            for (ptr_size p = 0; p < parts.size(); ++p)
             {
-                RAYCE_LOG_INFO("Loading: %s.", shape.filename.c_str());
-                tinyobj::ObjReader objReader;
-                tinyobj::ObjReaderConfig config;
-                config.triangulate = true;
-                bool success       = objReader.ParseFromFile(shape.filename.c_str(), config);
+                pGeometry->addInstance(geometryIndex + p, materialId, lightId, transformation);
 
-                if (!success)
+                if (state.compile)
                 {
-                    RAYCE_LOG_ERROR("Can not load: %s!", shape.filename.c_str());
-                    continue;
+                    CompiledMesh& compiledMesh = state.compiledScene.meshes[state.compiledScene.meshes.size() - parts.size() + p];
+                    compiledMesh.materialIds.push_back(materialId);
+                    compiledMesh.lightIds.push_back(lightId);
+                    compiledMesh.transformationMatrices.push_back(transformation);
                 }
+            }
+        }
+    }
 
-                if (!objReader.Warning().empty())
-                {
-                    RAYCE_LOG_WARN("TinyObjReader: %s", objReader.Warning().c_str());
-                }
+    if (!state.compile || merge)
+    {
+        // the data lives on the gpu or in the merged mesh now
+        mesh = MeshData();
+        chunks.clear();
+    }
 
-                auto& attrib = objReader.GetAttrib();
-                auto& shapes = objReader.GetShapes();
+    if (merge && state.pendingMerge.triangleMaterialIds.size() >= kMergedMeshTriangleBudget)
+    {
+        flushMergedMeshes(state, logicalDevice, commandPool);
+    }
+}
 
-                // FIXME: We could support setting in mitsuba files...
-                bool faceNormals = shape.type == EShapeType::cube; // ignore smoothing groups
+bool RayceScene::flushMergedMeshes(SceneLoadState& state, const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool)
+{
+    if (state.pendingMerge.triangleMaterialIds.empty())
+    {
+        return false;
+    }
 
-                bool hasPositions = !attrib.vertices.empty(), hasIndices = hasPositions, hasNormals = !attrib.normals.empty(), hasUVs = !attrib.texcoords.empty();
-                std::vector<uint32> indices;
-                std::vector<vec3> positions;
-                std::vector<vec3> normals;
-                std::vector<vec2> uvs;
-                uint32 vertIdx = 0;
+    state.mergedMeshes.push_back(std::move(state.pendingMerge));
+    state.pendingMerge                  = MergedMesh();
+    MergedMesh& merged                  = state.mergedMeshes.back();
+    std::span<const Vertex> vertices    = merged.mesh.getVertices();
+    std::span<const uint32> indices     = merged.mesh.getIndices();
+    std::span<const uint32> materialIds = merged.triangleMaterialIds;
+    const uint32 primitiveCount         = static_cast<uint32>(materialIds.size());
+
+    Timer timer;
+    timer.start();
+
+    std::unique_ptr<Buffer> positionBuffer;
+    std::unique_ptr<Buffer> attributeBuffer;
+    std::unique_ptr<Buffer> indexBuffer;
+    VkIndexType indexType;
+    VkDeviceSize uploadBytes =
+        createMeshBuffers(logicalDevice, commandPool, vertices, indices, merged.mesh.hasNormals || merged.mesh.hasUVs, state.options.shortIndices, state.options.compactAttributes, positionBuffer,
+                          attributeBuffer, indexBuffer, indexType);
+    std::unique_ptr<Buffer> triangleMaterialBuffer = createInputBuffer(logicalDevice, commandPool, materialIds.data(), materialIds.size(), 0);
+    uploadBytes += materialIds.size_bytes();
+    addLoadTiming(ESceneLoadPhase::meshUpload, elapsedMilliseconds(timer), uploadBytes);
+
+    // the transformations are baked, the instance material is only a fallback, the shaders read the per triangle materials
+    const ptr_size geometryIndex = pGeometry->getTriangleMeshes().size();
+    pGeometry->add(std::move(positionBuffer), std::move(attributeBuffer), state.options.compactAttributes, static_cast<uint32>(vertices.size()) - 1, std::move(indexBuffer), indexType, primitiveCount,
+                   materialIds[0], -1, { mat4::Identity() });
+    pGeometry->setTriangleMaterials(geometryIndex, std::move(triangleMaterialBuffer));
+
+    RAYCE_LOG_INFO("Merged %u meshes into one geometry with %u triangles.", merged.shapeCount, primitiveCount);
+
+    if (state.compile)
+    {
+        state.compiledScene.meshes.push_back({ vertices, indices, { materialIds[0] }, { -1 }, { mat4::Identity() }, materialIds, merged.mesh.hasNormals || merged.mesh.hasUVs });
+    }
+    else
+    {
+        state.mergedMeshes.pop_back();
+    }
 
-                std::unordered_map<uint32, uint32> simpleCache;
+    return true;
+}
 
-                for (size_t s = 0; s < shapes.size(); ++s)
-                {
-                    size_t indexOffset = 0;
-                    for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); ++f)
-                    {
-                        size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
+void RayceScene::addSphereShape(SceneLoadState& state, ptr_size s)
+{
+    const MitsubaShape& shape = state.shapes[s];
 
-                        for (size_t v = 0; v < fv; v++)
-                        {
-                            tinyobj::index_t idx = shapes[s].mesh.indices[indexOffset + v];
+    // materialId is filled before
+    uint32 materialId                = state.bsdfs[shape.bsdf].materialId;
+    mMaterials[materialId]->canUseUv = false;
 
-                            if (!faceNormals && simpleCache.find(idx.vertex_index) != simpleCache.end())
-                            {
-                                uint32 vIdx = simpleCache[idx.vertex_index];
-                                indices.push_back(vIdx);
-                                continue;
-                            }
+    // spheres are resolved to world space, so every instance of a grouped sphere is a sphere of its own
+    for (const mat4& transformation : shapeTransformations(shape))
+    {
+        std::unique_ptr<Sphere> sphere                      = std::make_unique<Sphere>();
+        sphere->center                                      = (transformation * vec4(0.0, 0.0, 0.0, 1.0)).head<3>();
+        sphere->radius                                      = ((transformation * vec4(1.0, 0.0, 0.0, 1.0)).head<3>() - sphere->center).norm();
+        std::unique_ptr<AxisAlignedBoundingBox> boundingBox = std::make_unique<AxisAlignedBoundingBox>();
+        boundingBox->minimum                                = sphere->center - vec3(sphere->radius, sphere->radius, sphere->radius);
+        boundingBox->maximum                                = sphere->center + vec3(sphere->radius, sphere->radius, sphere->radius);
+
+        state.sceneBounds.minimum = state.sceneBounds.minimum.cwiseMin(boundingBox->minimum);
+        state.sceneBounds.maximum = state.sceneBounds.maximum.cwiseMax(boundingBox->maximum);
+
+        int32 lightId = -1;
+        if (shape.emitter >= 0)
+        {
+            lightId = state.emitters[shape.emitter].lightId;
 
-                            indices.push_back(vertIdx);
+            // convert light data to our type
+            std::unique_ptr<Light>& lightData = mLights[lightId];
 
-                            simpleCache[idx.vertex_index] = vertIdx;
+            assert(lightData->type == ELightType::area); // atm analytic sphere
 
-                            tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0];
-                            tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
-                            tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
+            lightData->type = ELightType::analyticSphere;
 
-                            positions.push_back(vec3(vx, vy, vz));
+            lightData->wCenter      = sphere->center;
+            lightData->surfaceArea  = (2.0 * TWO_PI * sphere->radius * sphere->radius);
+            lightData->lightToWorld = transformation;
+            lightData->worldToLight = transformation.inverse();
+        }
 
-                            if (idx.normal_index >= 0)
-                            {
-                                tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
-                                tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
-                                tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
+        if (state.compile)
+        {
+            state.compiledScene.spheres.push_back({ *sphere, *boundingBox, materialId, lightId, { mat4::Identity() } });
+        }
 
-                                normals.push_back(vec3(nx, ny, nz));
-                            }
+        pGeometry->add(std::move(sphere), std::move(boundingBox), materialId, lightId, { mat4::Identity() });
+    }
+}
 
-                            if (idx.texcoord_index >= 0)
-                            {
-                                tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
-                                tinyobj::real_t ty = attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
+void RayceScene::finishSceneLoad()
+{
+    SceneLoadState& state = *pLoadState;
+    if (state.worker.joinable())
+    {
+        state.worker.join();
+    }
 
-                                uvs.push_back(vec2(tx, ty));
-                            }
-                            vertIdx++;
-                        }
-                        indexOffset += fv;
-                    }
-                }
+    if (state.compile)
+    {
+        CompiledScene& compiledScene = state.compiledScene;
+        for (const auto& material : mMaterials)
+        {
+            compiledScene.materials.push_back(*material);
+        }
+        for (const auto& light : mLights)
+        {
+            compiledScene.lights.push_back(*light);
+        }
+        compiledScene.meshNames              = mReflectionInfo.meshNames;
+        compiledScene.meshTriCounts          = mReflectionInfo.meshTriCounts;
+        compiledScene.meshSourceTriCounts    = mReflectionInfo.meshSourceTriCounts;
+        compiledScene.meshVertexCounts       = mReflectionInfo.meshVertexCounts;
+        compiledScene.meshSourceVertexCounts = mReflectionInfo.meshSourceVertexCounts;
 
-                if (!(hasPositions && hasIndices))
-                {
-                    RAYCE_LOG_ERROR("%s has no positions or indices!", shape.filename.c_str());
-                    continue;
-                }
+        writeCompiledScene(state.options.compiledSceneFile, compiledScene);
+    }
 
-                std::vector<Vertex> vertices(positions.size());
-                for (ptr_size v = 0; v < positions.size(); ++v)
-                {
-                    Vertex vertex;
+    mReflectionInfo.loadMilliseconds = elapsedMilliseconds(state.loadTimer);
+    RAYCE_LOG_INFO("Loaded scene %s in %.1f ms.", mReflectionInfo.filename.c_str(), mReflectionInfo.loadMilliseconds);
 
-                    vertex.position = positions[v];
-                    vertex.normal   = hasNormals ? normals[v].normalized() : vec3(0.0, 0.0, 0.0);
-                    vertex.uv       = hasUVs ? uvs[v] : vec2(1.0, 1.0);
+    pLoadState.reset();
+}
 
-                    sceneBounds.minimum = sceneBounds.minimum.cwiseMin((shape.transformationMatrix * vertex.position.homogeneous()).head<3>());
-                    sceneBounds.maximum = sceneBounds.maximum.cwiseMax((shape.transformationMatrix * vertex.position.homogeneous()).head<3>());
+void RayceScene::cancelSceneLoad()
+{
+    if (!pLoadState)
+    {
+        return;
+    }
 
-                    vertices[v] = vertex;
-                }
+    pLoadState->cancel = true;
+    if (pLoadState->worker.joinable())
+    {
+        pLoadState->worker.join();
+    }
+    pLoadState.reset();
+}
 
-                std::unique_ptr<Buffer> vertexBuffer = std::make_unique<Buffer>(logicalDevice, sizeof(Vertex) * vertices.size(),
-                                                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-                                                                                    VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-                std::unique_ptr<Buffer> indexBuffer  = std::make_unique<Buffer>(logicalDevice, sizeof(uint32) * indices.size(),
-                                                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-                                                                                    VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+bool RayceScene::loadFromCompiledFile(const str& filename, const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, const SceneLoadOptions& options)
+{
+    RAYCE_LOG_INFO("Loading compiled scene %s.", filename.c_str());
 
-                vertexBuffer->allocateMemory(logicalDevice, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-                indexBuffer->allocateMemory(logicalDevice, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    Timer loadTimer;
+    loadTimer.start();
 
-                Buffer::uploadDataWithStagingBuffer(logicalDevice, commandPool, *vertexBuffer, vertices);
-                Buffer::uploadDataWithStagingBuffer(logicalDevice, commandPool, *indexBuffer, indices);
+    CompiledScene compiledScene;
+    if (!readCompiledScene(filename, hashCompiledSceneOptions(options), compiledScene))
+    {
+        return false;
+    }
 
-                uint32 maxVertex      = static_cast<uint32>(vertices.size() - 1);
-                uint32 primitiveCount = static_cast<uint32>(indices.size() / 3);
-                mReflectionInfo.meshTriCounts[meshId + sphereId] += primitiveCount;
+    mReflectionInfo.loadPhases = {};
+    mReflectionInfo.meshLoadTimings.clear();
+    mReflectionInfo.textureLoadTimings.clear();
 
-                // materialId is filled before
-                uint32 materialId = mitsubaBSDFs[shape.bsdf].materialId;
-                int32 lightId     = -1;
-                if (shape.emitter >= 0)
-                {
-                    lightId                           = mitsubaEmitters[shape.emitter].lightId;
-                    std::unique_ptr<Light>& lightData = mLights[lightId];
-                    if (shape.type == EShapeType::rectangle)
-                    {
-                        // convert light data to our type
-                        assert(lightData->type == ELightType::area); // atm analytic rectangle
+    mReflectionInfo.filename               = filename;
+    mReflectionInfo.meshNames              = compiledScene.meshNames;
+    mReflectionInfo.meshTriCounts          = compiledScene.meshTriCounts;
+    mReflectionInfo.meshSourceTriCounts    = compiledScene.meshSourceTriCounts;
+    mReflectionInfo.meshVertexCounts       = compiledScene.meshVertexCounts;
+    mReflectionInfo.meshSourceVertexCounts = compiledScene.meshSourceVertexCounts;
+    // compiled scenes do not store the reordering statistics
+    mReflectionInfo.meshCacheMissesBefore.assign(compiledScene.meshNames.size(), 0.0f);
+    mReflectionInfo.meshCacheMissesAfter.assign(compiledScene.meshNames.size(), 0.0f);
 
-                        lightData->type = ELightType::analyticRectangle;
+    pGeometry = std::make_unique<Geometry>();
 
-                        lightData->wCenter      = (shape.transformationMatrix * vec4(0.0, 0.0, 0.0, 1.0)).head<3>(); // rectangle is xy [-1, 1]
-                        vec3 tmp                = (shape.transformationMatrix.block<3, 3>(0, 0) * vec3(2.0, 2.0, 0.0));
-                        lightData->surfaceArea  = std::abs(tmp.squaredNorm());
-                        lightData->lightToWorld = shape.transformationMatrix;
-                        lightData->worldToLight = shape.transformationMatrix.inverse();
-                    }
-                }
-                mMaterials[materialId]->canUseUv = hasUVs;
+    for (const Material& material : compiledScene.materials)
+    {
+        mMaterials.push_back(std::make_unique<Material>(material));
+    }
+    for (const Light& light : compiledScene.lights)
+    {
+        mLights.push_back(std::make_unique<Light>(light));
+    }
 
-                pGeometry->add(std::move(vertexBuffer), maxVertex, std::move(indexBuffer), primitiveCount, materialId, lightId, { shape.transformationMatrix });
-            }
+    mImages.resize(compiledScene.textures.size());
+    mImageViews.resize(compiledScene.textures.size());
+    mImageSamplers.resize(compiledScene.textures.size());
+    for (ptr_size i = 0; i < compiledScene.textures.size(); ++i)
+    {
+        const CompiledTexture& texture = compiledScene.textures[i];
 
-            meshId++;
-        }
-        else if (shape.type == EShapeType::sphere)
+        Timer timer;
+        timer.start();
+        uploadTexture(logicalDevice, commandPool, texture.pixels.data(), texture.width, texture.height, texture.components, texture.srgb, mImages[i], mImageViews[i], mImageSamplers[i]);
+        addLoadTiming(ESceneLoadPhase::textureUpload, elapsedMilliseconds(timer), texture.pixels.size_bytes());
+    }
+
+    for (const CompiledMesh& mesh : compiledScene.meshes)
+    {
+        Timer timer;
+        timer.start();
+
+        std::unique_ptr<Buffer> positionBuffer;
+        std::unique_ptr<Buffer> attributeBuffer;
+        std::unique_ptr<Buffer> indexBuffer;
+        VkIndexType indexType;
+        const VkDeviceSize uploadBytes = createMeshBuffers(logicalDevice, commandPool, mesh.vertices, mesh.indices, mesh.hasAttributes, options.shortIndices, options.compactAttributes, positionBuffer, attributeBuffer, indexBuffer, indexType);
+        addLoadTiming(ESceneLoadPhase::meshUpload, elapsedMilliseconds(timer), uploadBytes);
+
+        pGeometry->add(std::move(positionBuffer), std::move(attributeBuffer), options.compactAttributes, static_cast<uint32>(mesh.vertices.size() - 1), std::move(indexBuffer), indexType, static_cast<uint32>(mesh.indices.size() / 3), mesh.materialIds, mesh.lightIds,
+                       mesh.transformationMatrices);
+        if (!mesh.triangleMaterialIds.empty())
         {
-            std::unique_ptr<Sphere> sphere                      = std::make_unique<Sphere>();
-            sphere->center                                      = (shape.transformationMatrix * vec4(0.0, 0.0, 0.0, 1.0)).head<3>();
-            sphere->radius                                      = ((shape.transformationMatrix * vec4(1.0, 0.0, 0.0, 1.0)).head<3>() - sphere->center).norm();
-            std::unique_ptr<AxisAlignedBoundingBox> boundingBox = std::make_unique<AxisAlignedBoundingBox>();
-            boundingBox->minimum                                = sphere->center - vec3(sphere->radius, sphere->radius, sphere->radius);
-            boundingBox->maximum                                = sphere->center + vec3(sphere->radius, sphere->radius, sphere->radius);
+            pGeometry->setTriangleMaterials(pGeometry->getTriangleMeshes().size() - 1, createInputBuffer(logicalDevice, commandPool, mesh.triangleMaterialIds.data(), mesh.triangleMaterialIds.size(), 0));
+        }
+    }
 
-            sceneBounds.minimum = sceneBounds.minimum.cwiseMin(boundingBox->minimum);
-            sceneBounds.maximum = sceneBounds.maximum.cwiseMax(boundingBox->maximum);
+    for (const CompiledSphere& compiledSphere : compiledScene.spheres)
+    {
+        pGeometry->add(std::make_unique<Sphere>(compiledSphere.sphere), std::make_unique<AxisAlignedBoundingBox>(compiledSphere.boundingBox), compiledSphere.materialId, compiledSphere.lightId,
+                       compiledSphere.transformationMatrices);
+    }
 
-            // materialId is filled before
-            uint32 materialId = mitsubaBSDFs[shape.bsdf].materialId;
-            int32 lightId     = -1;
-            if (shape.emitter >= 0)
-            {
-                lightId = mitsubaEmitters[shape.emitter].lightId;
+    mReflectionInfo.loadMilliseconds = elapsedMilliseconds(loadTimer);
+    RAYCE_LOG_INFO("Loaded compiled scene %s in %.1f ms.", filename.c_str(), mReflectionInfo.loadMilliseconds);
 
-                // convert light data to our type
-                std::unique_ptr<Light>& lightData = mLights[lightId];
+    return true;
+}
 
-                assert(lightData->type == ELightType::area); // atm analytic sphere
+void RayceScene::addLoadTiming(ESceneLoadPhase phase, double milliseconds, uint64 bytes)
+{
+    SceneLoadPhaseTiming& timing = mReflectionInfo.loadPhases[static_cast<ptr_size>(phase)];
+    timing.milliseconds += milliseconds;
+    timing.bytes += bytes;
+    timing.count++;
+}
 
-                if (shape.type == EShapeType::sphere)
-                {
-                    lightData->type = ELightType::analyticSphere;
+static const char* loadPhaseName(ESceneLoadPhase phase)
+{
+    switch (phase)
+    {
+    case ESceneLoadPhase::xmlParse:
+        return "XML Parse";
+    case ESceneLoadPhase::conversion:
+        return "BSDF/Emitter Conversion";
+    case ESceneLoadPhase::spectrumReads:
+        return "Spectrum Reads";
+    case ESceneLoadPhase::textureDecode:
+        return "Texture Decode";
+    case ESceneLoadPhase::textureUpload:
+        return "Texture Upload";
+    case ESceneLoadPhase::meshParse:
+        return "Mesh Parse";
+    case ESceneLoadPhase::meshWeld:
+        return "Mesh Weld";
+    case ESceneLoadPhase::meshUpload:
+        return "Mesh Upload";
+    case ESceneLoadPhase::accelerationStructureBuild:
+        return "BLAS/TLAS Build";
+    default:
+        return "Unknown";
+    }
+}
 
-                    lightData->wCenter      = sphere->center;
-                    lightData->surfaceArea  = (2.0 * TWO_PI * sphere->radius * sphere->radius);
-                    lightData->lightToWorld = shape.transformationMatrix;
-                    lightData->worldToLight = shape.transformationMatrix.inverse();
-                }
+static str escapeJson(const str& value)
+{
+    str escaped;
+    escaped.reserve(value.size());
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        case '\t':
+            escaped += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", c);
+                escaped += code;
+            }
+            else
+            {
+                escaped += c;
             }
-            mMaterials[materialId]->canUseUv = false;
+            break;
+        }
+    }
+    return escaped;
+}
 
-            pGeometry->add(std::move(sphere), std::move(boundingBox), materialId, lightId, { mat4::Identity() });
+static void writeItemTimings(std::ofstream& file, const char* key, const std::vector<SceneLoadItemTiming>& timings)
+{
+    file << "  \"" << key << "\": [";
+    for (ptr_size i = 0; i < timings.size(); ++i)
+    {
+        const SceneLoadItemTiming& timing = timings[i];
+        file << (i == 0 ? "\n" : ",\n");
+        file << "    { \"name\": \"" << escapeJson(timing.name) << "\", \"loadMs\": " << timing.loadMilliseconds << ", \"weldMs\": " << timing.weldMilliseconds
+             << ", \"uploadMs\": " << timing.uploadMilliseconds << ", \"fileBytes\": " << timing.fileBytes << ", \"uploadBytes\": " << timing.uploadBytes << " }";
+    }
+    file << (timings.empty() ? "]" : "\n  ]");
+}
 
-            sphereId++;
-        }
+bool RayceScene::exportLoadProfile(const str& filename) const
+{
+    std::ofstream file(filename, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        RAYCE_LOG_ERROR("Can not write load profile %s!", filename.c_str());
+        return false;
     }
 
-    for (auto& light : mLights)
+    file << std::fixed << std::setprecision(3);
+    file << "{\n";
+    file << "  \"scene\": \"" << escapeJson(mReflectionInfo.filename) << "\",\n";
+    file << "  \"totalMs\": " << mReflectionInfo.loadMilliseconds << ",\n";
+    file << "  \"phases\": [";
+    for (ptr_size p = 0; p < mReflectionInfo.loadPhases.size(); ++p)
     {
-        if (light->type == ELightType::constant)
-        {
-            light->wCenter     = float3::Zero();
-            light->sceneRadius = std::max(sceneBounds.maximum.norm(), sceneBounds.minimum.norm());
-        }
+        const SceneLoadPhaseTiming& timing = mReflectionInfo.loadPhases[p];
+        file << (p == 0 ? "\n" : ",\n");
+        file << "    { \"name\": \"" << loadPhaseName(static_cast<ESceneLoadPhase>(p)) << "\", \"ms\": " << timing.milliseconds << ", \"bytes\": " << timing.bytes << ", \"count\": " << timing.count
+             << " }";
+    }
+    file << "\n  ],\n";
+    writeItemTimings(file, "meshes", mReflectionInfo.meshLoadTimings);
+    file << ",\n";
+    writeItemTimings(file, "textures", mReflectionInfo.textureLoadTimings);
+    file << "\n}\n";
+
+    if (!file.good())
+    {
+        RAYCE_LOG_ERROR("Can not write load profile %s!", filename.c_str());
+        return false;
     }
+
+    RAYCE_LOG_INFO("Wrote load profile %s.", filename.c_str());
+
+    return true;
 }
 
 void RayceScene::onImGuiRender()
@@ -2493,13 +2832,74 @@ void RayceScene::onImGuiRender()
     }
 
     ImGui::Spacing();
+    if (pLoadState)
+    {
+        uint32 loadedMeshes, meshCount, loadedTextures, textureCount;
+        getLoadProgress(loadedMeshes, meshCount, loadedTextures, textureCount);
+        ImGui::Text("Loading: %u of %u meshes, %u of %u textures", loadedMeshes, meshCount, loadedTextures, textureCount);
+        uint32 total = meshCount + textureCount;
+        ImGui::ProgressBar(total > 0 ? static_cast<float>(loadedMeshes + loadedTextures) / static_cast<float>(total) : 1.0f);
+        ImGui::Separator();
+    }
     static ImGuiTreeNodeFlags treeNodeFlags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
     if (ImGui::TreeNodeEx(mReflectionInfo.filename.c_str(), treeNodeFlags, "%s  %s", ICON_FA_FOLDER, mReflectionInfo.filename.c_str()))
     {
         ImGui::Indent();
+        uint64 vertexCount         = 0;
+        uint64 sourceVertexCount   = 0;
+        uint64 triangleCount       = 0;
+        uint64 sourceTriangleCount = 0;
+        for (ptr_size i = 0; i < mReflectionInfo.meshNames.size(); ++i)
+        {
+            vertexCount += mReflectionInfo.meshVertexCounts[i];
+            sourceVertexCount += mReflectionInfo.meshSourceVertexCounts[i];
+            if (mReflectionInfo.meshSourceTriCounts[i] > 0)
+            {
+                triangleCount += mReflectionInfo.meshTriCounts[i];
+                sourceTriangleCount += mReflectionInfo.meshSourceTriCounts[i];
+            }
+        }
+        if (sourceTriangleCount > triangleCount)
+        {
+            ImGui::Text("Cleanup: %llu of %llu triangles kept", triangleCount, sourceTriangleCount);
+            ImGui::Separator();
+        }
+        if (sourceVertexCount > 0)
+        {
+            ImGui::Text("Welding: %llu of %llu vertices kept (%.1f%%)", vertexCount, sourceVertexCount, 100.0 * static_cast<double>(vertexCount) / static_cast<double>(sourceVertexCount));
+            ImGui::Separator();
+        }
+        // triangle weighted average over all reordered meshes
+        double missesBefore = 0.0, missesAfter = 0.0, reorderedTriangles = 0.0;
+        for (ptr_size i = 0; i < mReflectionInfo.meshNames.size(); ++i)
+        {
+            if (mReflectionInfo.meshCacheMissesAfter[i] > 0.0f)
+            {
+                missesBefore += static_cast<double>(mReflectionInfo.meshCacheMissesBefore[i]) * mReflectionInfo.meshTriCounts[i];
+                missesAfter += static_cast<double>(mReflectionInfo.meshCacheMissesAfter[i]) * mReflectionInfo.meshTriCounts[i];
+                reorderedTriangles += mReflectionInfo.meshTriCounts[i];
+            }
+        }
+        if (reorderedTriangles > 0.0)
+        {
+            ImGui::Text("Reordering: %.2f -> %.2f estimated cache misses per triangle", missesBefore / reorderedTriangles, missesAfter / reorderedTriangles);
+            ImGui::Separator();
+        }
         for (ptr_size i = 0; i < mReflectionInfo.meshNames.size(); ++i)
         {
             ImGui::Text("%s %s: %d Triangles", ICON_FA_SHAPES, mReflectionInfo.meshNames[i].c_str(), mReflectionInfo.meshTriCounts[i]);
+            if (mReflectionInfo.meshSourceTriCounts[i] > mReflectionInfo.meshTriCounts[i])
+            {
+                ImGui::Text("%d Triangles before cleanup", mReflectionInfo.meshSourceTriCounts[i]);
+            }
+            if (mReflectionInfo.meshSourceVertexCounts[i] > 0)
+            {
+                ImGui::Text("%d Vertices, %d before welding", mReflectionInfo.meshVertexCounts[i], mReflectionInfo.meshSourceVertexCounts[i]);
+            }
+            if (mReflectionInfo.meshCacheMissesAfter[i] > 0.0f)
+            {
+                ImGui::Text("%.2f -> %.2f cache misses per triangle", mReflectionInfo.meshCacheMissesBefore[i], mReflectionInfo.meshCacheMissesAfter[i]);
+            }
             if (i < mReflectionInfo.meshNames.size() - 1)
             {
                 ImGui::Separator();
@@ -2508,5 +2908,42 @@ void RayceScene::onImGuiRender()
         ImGui::TreePop();
     }
 
+    if (ImGui::TreeNodeEx("Load Profile", treeNodeFlags, "%s  Load Profile", ICON_FA_CLOCK))
+    {
+        ImGui::Indent();
+        ImGui::Text("Total: %.1f ms", mReflectionInfo.loadMilliseconds);
+        ImGui::Separator();
+        for (ptr_size p = 0; p < mReflectionInfo.loadPhases.size(); ++p)
+        {
+            const SceneLoadPhaseTiming& timing = mReflectionInfo.loadPhases[p];
+            ImGui::Text("%s: %.1f ms, %.2f MiB, %u items", loadPhaseName(static_cast<ESceneLoadPhase>(p)), timing.milliseconds, static_cast<double>(timing.bytes) / (1024.0 * 1024.0), timing.count);
+        }
+
+        auto itemTimings = [](const char* label, const std::vector<SceneLoadItemTiming>& timings)
+        {
+            if (timings.empty() || !ImGui::TreeNode(label))
+            {
+                return;
+            }
+            for (const SceneLoadItemTiming& timing : timings)
+            {
+                ImGui::Text("%s: load %.1f ms, weld %.1f ms, upload %.1f ms, %.2f MiB", timing.name.c_str(), timing.loadMilliseconds, timing.weldMilliseconds, timing.uploadMilliseconds,
+                            static_cast<double>(timing.uploadBytes) / (1024.0 * 1024.0));
+            }
+            ImGui::TreePop();
+        };
+        ImGui::Separator();
+        itemTimings("Meshes", mReflectionInfo.meshLoadTimings);
+        itemTimings("Textures", mReflectionInfo.textureLoadTimings);
+
+        ImGui::Separator();
+        if (ImGui::Button("Export JSON"))
+        {
+            exportLoadProfile("load_profile.json");
+        }
+        ImGui::Unindent();
+        ImGui::TreePop();
+    }
+
     ImGui::End();
 }
@@ -9,10 +9,54 @@
 #ifndef RAYCE_SCENE_HPP
 #define RAYCE_SCENE_HPP
 
+#include <array>
 #include <unordered_map>
 
 namespace rayce
 {
+    /// @brief The profiled phases of a scene load.
+    enum class ESceneLoadPhase : byte
+    {
+        xmlParse = 0,
+        conversion,
+        spectrumReads,
+        textureDecode,
+        textureUpload,
+        meshParse,
+        meshWeld,
+        meshUpload,
+        accelerationStructureBuild,
+        count
+    };
+
+    /// @brief Accumulated time and data volume of one @a ESceneLoadPhase.
+    struct SceneLoadPhaseTiming
+    {
+        /// @brief The accumulated time in milliseconds, summed over all worker threads.
+        double milliseconds{ 0.0 };
+        /// @brief The number of bytes read or uploaded.
+        uint64 bytes{ 0 };
+        /// @brief The number of timed items.
+        uint32 count{ 0 };
+    };
+
+    /// @brief Load timings of a single mesh or texture.
+    struct SceneLoadItemTiming
+    {
+        /// @brief The name of the mesh or texture.
+        str name;
+        /// @brief The time to parse the mesh or decode the texture in milliseconds.
+        double loadMilliseconds{ 0.0 };
+        /// @brief The time spent welding the mesh in milliseconds.
+        double weldMilliseconds{ 0.0 };
+        /// @brief The time to upload the data to the GPU in milliseconds.
+        double uploadMilliseconds{ 0.0 };
+        /// @brief The size of the source file.
+        uint64 fileBytes{ 0 };
+        /// @brief The number of uploaded bytes.
+        uint64 uploadBytes{ 0 };
+    };
+
     /// @brief Stores reflection information for a @a RayceScene.
     struct SceneReflectionInfo
     {
@@ -22,8 +66,67 @@ namespace rayce
         std::vector<str> meshNames;
         /// @brief The triangle count of all meshes.
         std::vector<uint32> meshTriCounts;
+        /// @brief The triangle count of all meshes before removing degenerate and duplicate triangles, 0 if not cleaned up.
+        std::vector<uint32> meshSourceTriCounts;
+        /// @brief The vertex count of all meshes.
+        std::vector<uint32> meshVertexCounts;
+        /// @brief The vertex count of all meshes before welding.
+        std::vector<uint32> meshSourceVertexCounts;
+        /// @brief The estimated cache misses per triangle of all meshes before the triangle reordering, 0 if not reordered.
+        std::vector<float> meshCacheMissesBefore;
+        /// @brief The estimated cache misses per triangle of all meshes after the triangle reordering, 0 if not reordered.
+        std::vector<float> meshCacheMissesAfter;
+        /// @brief The wall clock time from the start of the load until everything was added in milliseconds.
+        double loadMilliseconds{ 0.0 };
+        /// @brief The timings per @a ESceneLoadPhase.
+        std::array<SceneLoadPhaseTiming, static_cast<ptr_size>(ESceneLoadPhase::count)> loadPhases;
+        /// @brief The timings of all loaded mesh files.
+        std::vector<SceneLoadItemTiming> meshLoadTimings;
+        /// @brief The timings of all loaded textures.
+        std::vector<SceneLoadItemTiming> textureLoadTimings;
     };
 
+    /// @brief Options controlling how a @a RayceScene is loaded.
+    struct SceneLoadOptions
+    {
+        /// @brief True if meshes should be parsed and preprocessed on worker threads, else False.
+        bool parallelMeshLoading = true;
+        /// @brief True if textures should be decoded on worker threads before the upload, else False.
+        bool parallelTextureDecoding = true;
+        /// @brief True if textures with identical content but different paths should share one image, else False.
+        /// @details Textures are always shared by canonical path, this additionally hashes every texture file.
+        bool hashTextureContent = false;
+        /// @brief True if loaded meshes should be stored in and loaded from the binary mesh cache, else False.
+        bool useMeshCache = true;
+        /// @brief The directory holding the binary mesh cache, empty to use the per user @a defaultMeshCacheDirectory().
+        str meshCacheDirectory;
+        /// @brief True if shapes referencing the same mesh file should share one geometry and BLAS, else False.
+        bool shareMeshes = true;
+        /// @brief True if all spectra in assets/spectra should be parsed in parallel before the bsdfs are converted, else False.
+        bool preloadSpectra = false;
+        /// @brief True if degenerate and duplicate triangles and unreferenced vertices should be removed from ply and obj meshes, else False.
+        bool cleanupMeshes = true;
+        /// @brief True if the triangles of loaded meshes should be reordered along a space filling curve for coherent hit shading, else False.
+        bool optimizeTriangleOrder = false;
+        /// @brief Meshes with more triangles are split into spatially coherent chunks with a BLAS each, 0 disables splitting.
+        /// @details Bounds the scratch memory and duration of a single BLAS build for huge meshes.
+        uint32 meshChunkTriangles = 0;
+        /// @brief Meshes placed once and not emitting light with at most this many triangles are merged into combined geometries, 0 disables merging.
+        /// @details The transformations are baked into the vertices and the materials are read per triangle, which saves BLASes and TLAS instances.
+        uint32 mergeTriangleLimit = 0;
+        /// @brief True if meshes with less than 65536 vertices should be uploaded with 16 bit indices, else False.
+        bool shortIndices = true;
+        /// @brief True if the attribute streams should hold @a CompactVertexAttributes with octahedral normals and half float uvs, else False.
+        bool compactAttributes = false;
+        /// @brief If not empty the loaded scene is additionally written to this compiled scene file.
+        str compiledSceneFile;
+        /// @brief True if meshes and textures should be loaded on a background thread, else False.
+        /// @details @a loadFromMitsubaFile returns after parsing and the finished meshes and textures are added by @a updateProgressiveLoad.
+        bool progressive = false;
+    };
+
+    struct SceneLoadState;
+
     /// @brief The scene storage of the pathtracer.
     class RAYCE_API_EXPORT RayceScene
     {
@@ -38,7 +141,38 @@ namespace rayce
         /// @param[in] logicalDevice The logical @a Device used to create necessary GPU structures.
         /// @param[in] commandPool @a CommandPool to get command buffers.
         /// @param[in] scale A scaling for the positions.
-        void loadFromMitsubaFile(const str& filename, const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool, float scale);
+        /// @param[in] options The @a SceneLoadOptions to use.
+        void loadFromMitsubaFile(const str& filename, const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool, float scale,
+                                 const SceneLoadOptions& options = SceneLoadOptions());
+
+        /// @brief Loads a compiled scene written by @a loadFromMitsubaFile.
+        /// @details Skips all parsing and conversion, the file is memory mapped and its contents are uploaded in bulk.
+        /// Fails if the scene was compiled with other @a SceneLoadOptions or one of its source files changed since.
+        /// @param[in] filename The compiled scene file.
+        /// @param[in] logicalDevice The logical @a Device used to create necessary GPU structures.
+        /// @param[in] commandPool @a CommandPool to get command buffers.
+        /// @param[in] options The @a SceneLoadOptions the scene would be loaded with from the mitsuba file.
+        /// @return True on success, else False.
+        bool loadFromCompiledFile(const str& filename, const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool,
+                                  const SceneLoadOptions& options = SceneLoadOptions());
+
+        /// @brief Adds the meshes and textures finished by the background threads of a progressive load.
+        /// @details Has to be called while the GPU does not use the scene data. Finishes the load once everything is added.
+        /// @param[in] logicalDevice The logical @a Device used to create necessary GPU structures.
+        /// @param[in] commandPool @a CommandPool to get command buffers.
+        /// @return True if geometry, lights or textures changed, else False.
+        bool updateProgressiveLoad(const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool);
+
+        /// @brief Checks if a progressive load is still running.
+        /// @return True if meshes or textures are still loading, else False.
+        bool isLoading() const;
+
+        /// @brief Retrieves the progress of a running progressive load.
+        /// @param[out] loadedMeshes The number of added mesh files.
+        /// @param[out] meshCount The number of mesh files to load.
+        /// @param[out] loadedTextures The number of added textures.
+        /// @param[out] textureCount The number of textures to load.
+        void getLoadProgress(uint32& loadedMeshes, uint32& meshCount, uint32& loadedTextures, uint32& textureCount) const;
 
         /// @brief Returns the created @a Geometry of the @a RayceScene.
         /// @return The created @a Geometry of the @a RayceScene.
@@ -75,10 +209,47 @@ namespace rayce
             return mImageSamplers;
         }
 
+        /// @brief Adds a timing measured outside of the @a RayceScene to the load profile.
+        /// @details Used for the acceleration structure builds done by the application.
+        /// @param[in] phase The @a ESceneLoadPhase the timing belongs to.
+        /// @param[in] milliseconds The measured time in milliseconds.
+        /// @param[in] bytes The number of processed bytes.
+        void addLoadTiming(ESceneLoadPhase phase, double milliseconds, uint64 bytes);
+
+        /// @brief Writes the load profile of the @a SceneReflectionInfo to a JSON file.
+        /// @param[in] filename The JSON file to write.
+        /// @return True on success, else False.
+        bool exportLoadProfile(const str& filename) const;
+
         /// @brief Renders the @a SceneReflectionInfo in an ImGui window.
         void onImGuiRender();
 
     private:
+        /// @brief Uploads a loaded mesh and adds it for all shapes sharing it.
+        /// @param[in] state The @a SceneLoadState of the running load.
+        /// @param[in] source The index of the shape the mesh was loaded for.
+        /// @param[in] logicalDevice The logical @a Device used to create necessary GPU structures.
+        /// @param[in] commandPool @a CommandPool to get command buffers.
+        void addMeshShapes(SceneLoadState& state, ptr_size source, const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool);
+
+        /// @brief Adds a sphere shape.
+        /// @param[in] state The @a SceneLoadState of the running load.
+        /// @param[in] s The index of the sphere shape.
+        void addSphereShape(SceneLoadState& state, ptr_size s);
+
+        /// @brief Uploads the pending merged mesh and adds it as a single geometry with per triangle materials.
+        /// @param[in] state The @a SceneLoadState of the running load.
+        /// @param[in] logicalDevice The logical @a Device used to create necessary GPU structures.
+        /// @param[in] commandPool @a CommandPool to get command buffers.
+        /// @return True if a geometry was added, False if no mesh was pending.
+        bool flushMergedMeshes(SceneLoadState& state, const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool);
+
+        /// @brief Joins the loading thread, writes the compiled scene if requested and releases the @a SceneLoadState.
+        void finishSceneLoad();
+
+        /// @brief Stops a running load and releases the @a SceneLoadState without adding the remaining data.
+        void cancelSceneLoad();
+
         /// @brief The @a Geometry of the @a RayceScene.
         std::unique_ptr<class Geometry> pGeometry;
 
@@ -94,7 +265,7 @@ namespace rayce
         /// @brief The list of @a Lights.
         std::vector<std::unique_ptr<struct Light>> mLights;
 
-        /// @brief Image cache to remember already loaded textures.
+        /// @brief Image cache to remember already loaded textures, keyed by canonical path and color space.
         std::unordered_map<str, byte*> mImageCache;
 
         /// @brief List of \a Images representing textures of the loaded @a Geometry.
@@ -104,6 +275,9 @@ namespace rayce
         std::vector<std::unique_ptr<class ImageView>> mImageViews;
         /// @brief List of \a Samplers for the images.
         std::vector<std::unique_ptr<Sampler>> mImageSamplers;
+
+        /// @brief The state of a running progressive load, nullptr if nothing is loading.
+        std::unique_ptr<SceneLoadState> pLoadState;
     };
 
 } // namespace rayce
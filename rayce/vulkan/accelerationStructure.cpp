@@ -16,6 +16,7 @@ using namespace rayce;
 AccelerationStructure::AccelerationStructure(const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, const AccelerationStructureInitData initData)
     : mVkLogicalDeviceRef(logicalDevice->getVkDevice())
     , mInstanceCount(initData.primitiveCount)
+    , mSize(0)
 {
     pRTF = std::make_unique<RTFunctions>(logicalDevice);
     // bottom level
@@ -40,8 +41,8 @@ AccelerationStructure::AccelerationStructure(const std::unique_ptr<class Device>
             accelerationStructureGeometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
             accelerationStructureGeometry.geometry.triangles.vertexData   = { initData.vertexDataDeviceAddress };
             accelerationStructureGeometry.geometry.triangles.maxVertex    = initData.maxVertex;
-            accelerationStructureGeometry.geometry.triangles.vertexStride = Vertex::getSize();
-            accelerationStructureGeometry.geometry.triangles.indexType    = VK_INDEX_TYPE_UINT32;
+            accelerationStructureGeometry.geometry.triangles.vertexStride = initData.vertexStride;
+            accelerationStructureGeometry.geometry.triangles.indexType    = initData.indexType;
             accelerationStructureGeometry.geometry.triangles.indexData    = { initData.indexDataDeviceAddress };
         }
 
@@ -65,6 +66,7 @@ AccelerationStructure::AccelerationStructure(const std::unique_ptr<class Device>
         accelerationStructureCreateInfo.sType  = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
         accelerationStructureCreateInfo.buffer = pStorageBuffer->getVkBuffer();
         accelerationStructureCreateInfo.size   = accelerationStructureBuildSizesInfo.accelerationStructureSize;
+        mSize                                  = accelerationStructureBuildSizesInfo.accelerationStructureSize;
         accelerationStructureCreateInfo.type   = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
         RAYCE_CHECK_VK(pRTF->vkCreateAccelerationStructureKHR(mVkLogicalDeviceRef, &accelerationStructureCreateInfo, nullptr, &mVkAccelerationStructure), "Creating accelerating structure failed!");
 
@@ -151,6 +153,7 @@ AccelerationStructure::AccelerationStructure(const std::unique_ptr<class Device>
         accelerationStructureCreateInfo.sType  = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
         accelerationStructureCreateInfo.buffer = pStorageBuffer->getVkBuffer();
         accelerationStructureCreateInfo.size   = accelerationStructureBuildSizesInfo.accelerationStructureSize;
+        mSize                                  = accelerationStructureBuildSizesInfo.accelerationStructureSize;
         accelerationStructureCreateInfo.type   = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
         RAYCE_CHECK_VK(pRTF->vkCreateAccelerationStructureKHR(mVkLogicalDeviceRef, &accelerationStructureCreateInfo, nullptr, &mVkAccelerationStructure), "Creating accelerating structure failed!");
 
@@ -18,8 +18,12 @@ namespace rayce
         VkAccelerationStructureTypeKHR type;
         /// @brief Device address of the vertex buffer (Only BLAS and not procedural).
         VkDeviceAddress vertexDataDeviceAddress;
+        /// @brief Stride of the positions in the vertex buffer (Only BLAS and not procedural).
+        VkDeviceSize vertexStride = sizeof(vec3);
         /// @brief Device address of the index buffer (Only BLAS and not procedural).
         VkDeviceAddress indexDataDeviceAddress;
+        /// @brief Type of the indices in the index buffer (Only BLAS and not procedural).
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
         /// @brief List of device addresses of bottom level acceleration structures (Only TLAS).
         std::vector<std::pair<VkDeviceAddress, uint32>> blasDeviceAddresses;
         /// @brief List of transform matrices of bottom level acceleration structures (Only TLAS).
@@ -67,6 +71,13 @@ namespace rayce
             return mInstanceCount;
         }
 
+        /// @brief Retrieves the size of the built @a AccelerationStructure.
+        /// @return The size of the @a AccelerationStructure storage in bytes.
+        VkDeviceSize getSize() const
+        {
+            return mSize;
+        }
+
     private:
         /// @brief The underlying vulkan acceleration structure handle.
         VkAccelerationStructureKHR mVkAccelerationStructure;
@@ -80,6 +91,8 @@ namespace rayce
         std::unique_ptr<class RTFunctions> pRTF;
 
         uint mInstanceCount;
+        /// @brief The size of the storage @a Buffer in bytes.
+        VkDeviceSize mSize;
     };
 } // namespace rayce
 
@@ -40,7 +40,13 @@ namespace rayce
         template <class T>
         static void uploadDataWithStagingBuffer(const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, Buffer& dstBuffer, const std::vector<T>& data)
         {
-            const ptr_size size = sizeof(data[0]) * data.size();
+            Buffer::uploadDataWithStagingBuffer(logicalDevice, commandPool, dstBuffer, data.data(), data.size());
+        }
+
+        template <class T>
+        static void uploadDataWithStagingBuffer(const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, Buffer& dstBuffer, const T* data, ptr_size count)
+        {
+            const ptr_size size = sizeof(T) * count;
 
             if (size == 0)
             {
@@ -52,7 +58,7 @@ namespace rayce
             const std::unique_ptr<DeviceMemory>& deviceMemory = stagingBuffer->getDeviceMemory();
 
             void* mapped = deviceMemory->map(0, size);
-            std::memcpy(mapped, data.data(), size);
+            std::memcpy(mapped, data, size);
             deviceMemory->unmap();
 
             dstBuffer.fillFrom(logicalDevice, commandPool, *stagingBuffer, size);
@@ -10,20 +10,50 @@
 
 using namespace rayce;
 
-void Geometry::add(std::unique_ptr<Buffer>&& vertexBuffer, uint32 maxVertex, std::unique_ptr<Buffer>&& indexBuffer, uint32 primitiveCount, uint32 materialId, int32 lightId, const std::vector<mat4>& transformationMatrices)
+void Geometry::add(std::unique_ptr<Buffer>&& positionBuffer, std::unique_ptr<Buffer>&& attributeBuffer, bool compactAttributes, uint32 maxVertex, std::unique_ptr<Buffer>&& indexBuffer,
+                   VkIndexType indexType, uint32 primitiveCount, uint32 materialId, int32 lightId, const std::vector<mat4>& transformationMatrices)
 {
+    add(std::move(positionBuffer), std::move(attributeBuffer), compactAttributes, maxVertex, std::move(indexBuffer), indexType, primitiveCount, std::vector<uint32>(transformationMatrices.size(), materialId),
+        std::vector<int32>(transformationMatrices.size(), lightId), transformationMatrices);
+}
+
+void Geometry::add(std::unique_ptr<Buffer>&& positionBuffer, std::unique_ptr<Buffer>&& attributeBuffer, bool compactAttributes, uint32 maxVertex, std::unique_ptr<Buffer>&& indexBuffer,
+                   VkIndexType indexType, uint32 primitiveCount, const std::vector<uint32>& materialIds, const std::vector<int32>& lightIds, const std::vector<mat4>& transformationMatrices)
+{
+    RAYCE_ASSERT(materialIds.size() == transformationMatrices.size() && lightIds.size() == transformationMatrices.size(), "Every instance requires a material, a light and a transformation!");
+
     TriangleMeshGeometry geom;
-    geom.vertexBuffer   = std::move(vertexBuffer);
-    geom.indexBuffer    = std::move(indexBuffer);
-    geom.maxVertex      = maxVertex;
-    geom.primitiveCount = primitiveCount;
-    geom.materialId     = materialId;
-    geom.lightId = lightId;
+    geom.positionBuffer    = std::move(positionBuffer);
+    geom.attributeBuffer   = std::move(attributeBuffer);
+    geom.compactAttributes = compactAttributes;
+    geom.indexBuffer       = std::move(indexBuffer);
+    geom.indexType         = indexType;
+    geom.maxVertex         = maxVertex;
+    geom.primitiveCount    = primitiveCount;
+    geom.materialIds       = materialIds;
+    geom.lightIds          = lightIds;
     geom.transformationMatrices.insert(geom.transformationMatrices.end(), transformationMatrices.begin(), transformationMatrices.end());
 
     mTriangleMeshes.push_back(std::move(geom));
 }
 
+void Geometry::addInstance(ptr_size triangleMeshIndex, uint32 materialId, int32 lightId, const mat4& transformationMatrix)
+{
+    RAYCE_ASSERT(triangleMeshIndex < mTriangleMeshes.size(), "Triangle mesh index out of range!");
+
+    TriangleMeshGeometry& geom = mTriangleMeshes[triangleMeshIndex];
+    geom.materialIds.push_back(materialId);
+    geom.lightIds.push_back(lightId);
+    geom.transformationMatrices.push_back(transformationMatrix);
+}
+
+void Geometry::setTriangleMaterials(ptr_size triangleMeshIndex, std::unique_ptr<Buffer>&& triangleMaterialBuffer)
+{
+    RAYCE_ASSERT(triangleMeshIndex < mTriangleMeshes.size(), "Triangle mesh index out of range!");
+
+    mTriangleMeshes[triangleMeshIndex].triangleMaterialBuffer = std::move(triangleMaterialBuffer);
+}
+
 void Geometry::add(std::unique_ptr<Sphere>&& sphere, std::unique_ptr<AxisAlignedBoundingBox>&& boundingBox, uint32 materialId, int32 lightId, const std::vector<mat4>& transformationMatrices)
 {
     ProceduralSphereGeometry geom;
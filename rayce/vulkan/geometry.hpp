@@ -13,14 +13,24 @@ namespace rayce
 {
     struct RAYCE_API_EXPORT TriangleMeshGeometry
     {
-        std::unique_ptr<class Buffer> vertexBuffer;
+        // tightly packed positions, the BLAS input
+        std::unique_ptr<class Buffer> positionBuffer;
+        // normals and uvs for shading, null for proxies without attributes
+        std::unique_ptr<class Buffer> attributeBuffer;
+        // the attribute buffer holds CompactVertexAttributes instead of VertexAttributes
+        bool compactAttributes;
         std::unique_ptr<class Buffer> indexBuffer;
+        // meshes with less than 65536 vertices use 16 bit indices
+        VkIndexType indexType;
+        // material index per triangle of merged meshes, null if the instance material is used
+        std::unique_ptr<class Buffer> triangleMaterialBuffer;
 
         uint32 maxVertex;
         uint32 primitiveCount;
 
-        uint32 materialId;
-        int32 lightId;
+        // one entry per instance, all instances share the buffers and the BLAS
+        std::vector<uint32> materialIds;
+        std::vector<int32> lightIds;
 
         std::vector<mat4> transformationMatrices;
     };
@@ -38,7 +48,12 @@ namespace rayce
     class RAYCE_API_EXPORT Geometry
     {
     public:
-        void add(std::unique_ptr<class Buffer>&& vertexBuffer, uint32 maxVertex, std::unique_ptr<class Buffer>&& indexBuffer, uint32 primitiveCount, uint32 materialId, int32 lightId, const std::vector<mat4>& transformationMatrices);
+        void add(std::unique_ptr<class Buffer>&& positionBuffer, std::unique_ptr<class Buffer>&& attributeBuffer, bool compactAttributes, uint32 maxVertex, std::unique_ptr<class Buffer>&& indexBuffer,
+                 VkIndexType indexType, uint32 primitiveCount, uint32 materialId, int32 lightId, const std::vector<mat4>& transformationMatrices);
+        void add(std::unique_ptr<class Buffer>&& positionBuffer, std::unique_ptr<class Buffer>&& attributeBuffer, bool compactAttributes, uint32 maxVertex, std::unique_ptr<class Buffer>&& indexBuffer,
+                 VkIndexType indexType, uint32 primitiveCount, const std::vector<uint32>& materialIds, const std::vector<int32>& lightIds, const std::vector<mat4>& transformationMatrices);
+        void addInstance(ptr_size triangleMeshIndex, uint32 materialId, int32 lightId, const mat4& transformationMatrix);
+        void setTriangleMaterials(ptr_size triangleMeshIndex, std::unique_ptr<class Buffer>&& triangleMaterialBuffer);
         void add(std::unique_ptr<struct Sphere>&& sphere, std::unique_ptr<class AxisAlignedBoundingBox>&& boundingBox, uint32 materialId, int32 lightId, const std::vector<mat4>& transformationMatrices);
 
         const std::vector<TriangleMeshGeometry>& getTriangleMeshes() const
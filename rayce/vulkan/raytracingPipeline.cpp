@@ -25,7 +25,7 @@ using namespace rayce;
 
 RaytracingPipeline::RaytracingPipeline(const std::unique_ptr<Device>& logicalDevice, const std::unique_ptr<CommandPool>& commandPool, const std::unique_ptr<Swapchain>& swapchain,
                                        const std::unique_ptr<AccelerationStructure>& tlas, const std::vector<VkBuffer>& vertexBuffers, const std::vector<VkBuffer>& indexBuffers,
-                                       CameraDataRT& cameraData, uint32 requiredImageDescriptors, const std::unique_ptr<ImageView>& outputImage, uint32 framesInFlight)
+                                       const std::vector<VkBuffer>& attributeBuffers, const std::vector<VkBuffer>& triangleMaterialBuffers, CameraDataRT& cameraData, uint32 requiredImageDescriptors, const std::unique_ptr<ImageView>& outputImage, uint32 framesInFlight)
     : mVkLogicalDeviceRef(logicalDevice->getVkDevice())
     , mFramesInFlight(framesInFlight)
 {
@@ -73,7 +73,19 @@ RaytracingPipeline::RaytracingPipeline(const std::unique_ptr<Device>& logicalDev
     layoutBindingIndexBuffer.descriptorCount = descriptorBufferCount;
     layoutBindingIndexBuffer.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
 
-    bindings = { layoutBindingVertexBuffer, layoutBindingIndexBuffer };
+    VkDescriptorSetLayoutBinding layoutBindingAttributeBuffer{};
+    layoutBindingAttributeBuffer.binding         = ATTRIBUTE_BINDING;
+    layoutBindingAttributeBuffer.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    layoutBindingAttributeBuffer.descriptorCount = descriptorBufferCount;
+    layoutBindingAttributeBuffer.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
+    VkDescriptorSetLayoutBinding layoutBindingTriangleMaterialBuffer{};
+    layoutBindingTriangleMaterialBuffer.binding         = TRIANGLE_MATERIAL_BINDING;
+    layoutBindingTriangleMaterialBuffer.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    layoutBindingTriangleMaterialBuffer.descriptorCount = descriptorBufferCount;
+    layoutBindingTriangleMaterialBuffer.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
+    bindings = { layoutBindingVertexBuffer, layoutBindingIndexBuffer, layoutBindingAttributeBuffer, layoutBindingTriangleMaterialBuffer };
 
     pDescriptorSetLayoutInput = std::make_unique<DescriptorSetLayout>(logicalDevice, bindings, 0, layoutBindingVertexBuffer.descriptorCount);
 
@@ -239,7 +251,7 @@ RaytracingPipeline::RaytracingPipeline(const std::unique_ptr<Device>& logicalDev
     pShaderBindingTableBuffer->getDeviceMemory()->unmap();
 
     // descriptor sets
-    const uint32 descriptorsPerFrameStorageBuffers = descriptorBufferCount * 2 + 4; // input set (vertex+index) + model set (instance/material/light/sphere)
+    const uint32 descriptorsPerFrameStorageBuffers = descriptorBufferCount * 4 + 4; // input set (position+index+attribute+triangle material) + model set (instance/material/light/sphere)
     const uint32 storageBufferDescriptorCount      = std::max<uint32>(1u, descriptorsPerFrameStorageBuffers * framesInFlight);
     const uint32 imageSamplerDescriptorCount       = std::max<uint32>(1u, requiredImageDescriptors * framesInFlight);
 
@@ -339,6 +351,26 @@ RaytracingPipeline::RaytracingPipeline(const std::unique_ptr<Device>& logicalDev
         indexBufferInfos.push_back(indexBufferInfo);
     }
 
+    VkDescriptorBufferInfo attributeBufferInfo{};
+    attributeBufferInfo.offset = 0;
+    attributeBufferInfo.range  = VK_WHOLE_SIZE;
+    std::vector<VkDescriptorBufferInfo> attributeBufferInfos;
+    for (auto& buf : attributeBuffers)
+    {
+        attributeBufferInfo.buffer = buf;
+        attributeBufferInfos.push_back(attributeBufferInfo);
+    }
+
+    VkDescriptorBufferInfo triangleMaterialBufferInfo{};
+    triangleMaterialBufferInfo.offset = 0;
+    triangleMaterialBufferInfo.range  = VK_WHOLE_SIZE;
+    std::vector<VkDescriptorBufferInfo> triangleMaterialBufferInfos;
+    for (auto& buf : triangleMaterialBuffers)
+    {
+        triangleMaterialBufferInfo.buffer = buf;
+        triangleMaterialBufferInfos.push_back(triangleMaterialBufferInfo);
+    }
+
     VkWriteDescriptorSet vertexBufferWrite{};
     vertexBufferWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     vertexBufferWrite.dstBinding      = VERTEX_BINDING;
@@ -353,6 +385,20 @@ RaytracingPipeline::RaytracingPipeline(const std::unique_ptr<Device>& logicalDev
     indexBufferWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     indexBufferWrite.pBufferInfo     = indexBufferInfos.data();
 
+    VkWriteDescriptorSet attributeBufferWrite{};
+    attributeBufferWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    attributeBufferWrite.dstBinding      = ATTRIBUTE_BINDING;
+    attributeBufferWrite.descriptorCount = attributeBuffers.size();
+    attributeBufferWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    attributeBufferWrite.pBufferInfo     = attributeBufferInfos.data();
+
+    VkWriteDescriptorSet triangleMaterialBufferWrite{};
+    triangleMaterialBufferWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    triangleMaterialBufferWrite.dstBinding      = TRIANGLE_MATERIAL_BINDING;
+    triangleMaterialBufferWrite.descriptorCount = triangleMaterialBuffers.size();
+    triangleMaterialBufferWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    triangleMaterialBufferWrite.pBufferInfo     = triangleMaterialBufferInfos.data();
+
     // uniform buffer update
     for (ptr_size i = 0; i < framesInFlight; ++i)
     {
@@ -362,9 +408,11 @@ RaytracingPipeline::RaytracingPipeline(const std::unique_ptr<Device>& logicalDev
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = { accelerationStructureWrite, accumImageWrite, resultImageWrite };
         pDescriptorSetsRT->update(writeDescriptorSets);
 
-        vertexBufferWrite.dstSet = pDescriptorSetsInput->operator[](static_cast<uint32>(i));
-        indexBufferWrite.dstSet  = pDescriptorSetsInput->operator[](static_cast<uint32>(i));
-        writeDescriptorSets      = { vertexBufferWrite, indexBufferWrite };
+        vertexBufferWrite.dstSet    = pDescriptorSetsInput->operator[](static_cast<uint32>(i));
+        indexBufferWrite.dstSet     = pDescriptorSetsInput->operator[](static_cast<uint32>(i));
+        attributeBufferWrite.dstSet        = pDescriptorSetsInput->operator[](static_cast<uint32>(i));
+        triangleMaterialBufferWrite.dstSet = pDescriptorSetsInput->operator[](static_cast<uint32>(i));
+        writeDescriptorSets                = { vertexBufferWrite, indexBufferWrite, attributeBufferWrite, triangleMaterialBufferWrite };
         pDescriptorSetsInput->update(writeDescriptorSets);
 
         memcpy(mCameraBuffersMapped[i], &cameraData, bufferSize);
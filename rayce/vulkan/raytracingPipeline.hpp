@@ -18,7 +18,7 @@ namespace rayce
 
         RaytracingPipeline(const std::unique_ptr<class Device>& logicalDevice, const std::unique_ptr<class CommandPool>& commandPool, const std::unique_ptr<class Swapchain>& swapchain,
                            const std::unique_ptr<class AccelerationStructure>& tlas, const std::vector<VkBuffer>& vertexBuffers, const std::vector<VkBuffer>& indexBuffers,
-                           CameraDataRT& cameraData, uint32 requiredImageDescriptors, const std::unique_ptr<class ImageView>& outputImage, uint32 framesInFlight);
+                           const std::vector<VkBuffer>& attributeBuffers, const std::vector<VkBuffer>& triangleMaterialBuffers, CameraDataRT& cameraData, uint32 requiredImageDescriptors, const std::unique_ptr<class ImageView>& outputImage, uint32 framesInFlight);
         ~RaytracingPipeline();
 
         VkPipelineLayout getVkPipelineLayout() const